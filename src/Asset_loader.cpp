@@ -0,0 +1,196 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+#include <cstdio>
+#include <cstring>
+#include <cstdint>
+#include <utility>
+#include "Asset_loader.h"
+#include "Telemetry.h"
+
+enum AssetKind { ASSET_IMAGE, ASSET_SOUND, ASSET_FONT };
+
+struct AssetJob {
+    AssetKind kind;
+    char path[64];
+    int size; // font point size
+    SDL_Surface* surface;
+    Mix_Chunk* chunk;
+    TTF_Font* font;
+    SDL_sem* done;
+    bool waited; // main thread only
+    Uint64 start, end; // performance counter
+    int worker;
+};
+
+static AssetJob gJobs[MAX_STARTUP_ASSETS];
+static int gJobCount = 0;
+static SDL_atomic_t gNextJob;
+static SDL_Thread* gWorkers[4];
+static int gWorkerCount = 0;
+static SDL_sem* gAudioGate = nullptr; // posted once per worker when the device is open
+static bool gAudioOk = false;
+static bool gAudioSignalled = false;
+
+struct StartupEvent {
+    const char* what;
+    Uint64 at;
+};
+static StartupEvent gMarks[16];
+static int gMarkCount = 0;
+static Uint64 gStartupZero = 0;
+static bool gStartupLogged = false;
+
+static void Queue(AssetKind kind, const char* path, int size) {
+    if (gJobCount == MAX_STARTUP_ASSETS || gWorkerCount) return;
+    AssetJob& j = gJobs[gJobCount++];
+    memset(&j, 0, sizeof(j));
+    j.kind = kind;
+    snprintf(j.path, sizeof(j.path), "%s", path);
+    j.size = size;
+}
+
+void AssetQueueImage(const char* path) { Queue(ASSET_IMAGE, path, 0); }
+void AssetQueueSound(const char* path) { Queue(ASSET_SOUND, path, 0); }
+void AssetQueueFont(const char* path, int size) { Queue(ASSET_FONT, path, size); }
+
+static int AssetWorker(void* arg) {
+    int worker = (int)(intptr_t)arg;
+    bool gatePassed = false;
+    // jobs are taken in queue order, sounds go last so waiting for the
+    // audio device never holds up an image
+    for (int i; (i = SDL_AtomicAdd(&gNextJob, 1)) < gJobCount; ) {
+        AssetJob& j = gJobs[i];
+        if (j.kind == ASSET_SOUND && !gatePassed) {
+            SDL_SemWait(gAudioGate);
+            gatePassed = true;
+        }
+        j.worker = worker;
+        j.start = SDL_GetPerformanceCounter();
+        switch (j.kind) {
+        case ASSET_IMAGE:
+            j.surface = IMG_Load(j.path);
+            if (!j.surface) SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Decode %s failed: %s", j.path, IMG_GetError());
+            break;
+        case ASSET_SOUND:
+            if (gAudioOk) j.chunk = Mix_LoadWAV(j.path);
+            break;
+        case ASSET_FONT:
+            j.font = TTF_OpenFont(j.path, j.size);
+            break;
+        }
+        j.end = SDL_GetPerformanceCounter();
+        TelemetryPush(TEL_ASSET, TelemetryUsSince(j.start), 0, j.path);
+        SDL_SemPost(j.done);
+    }
+    return 0;
+}
+
+void AssetsStart() {
+    if (gWorkerCount || gJobCount == 0) return;
+    // sorted by kind: images and the font first, sounds wait for the device
+    for (int i = 1; i < gJobCount; ++i)
+        for (int k = i; k > 0 && gJobs[k].kind == ASSET_SOUND && gJobs[k-1].kind != ASSET_SOUND; --k)
+            std::swap(gJobs[k], gJobs[k-1]);
+    for (int i = 0; i < gJobCount; ++i) gJobs[i].done = SDL_CreateSemaphore(0);
+    gAudioGate = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&gNextJob, 0);
+    int n = SDL_max(1, SDL_min(SDL_GetCPUCount() - 1, (int)SDL_arraysize(gWorkers)));
+    n = SDL_min(n, gJobCount);
+    for (int i = 0; i < n; ++i) {
+        gWorkers[gWorkerCount] = SDL_CreateThread(AssetWorker, "assets", (void*)(intptr_t)i);
+        if (gWorkers[gWorkerCount]) ++gWorkerCount;
+    }
+    if (gWorkerCount == 0) {
+        // no threads: nothing is cached, the loaders read the files themselves
+        for (int i = 0; i < gJobCount; ++i) SDL_DestroySemaphore(gJobs[i].done);
+        gJobCount = 0;
+        return;
+    }
+    StartupMark("decode started");
+}
+
+void AssetsAudioOpened(bool ok) {
+    if (gAudioSignalled || !gAudioGate) return;
+    gAudioOk = ok;
+    gAudioSignalled = true;
+    for (int i = 0; i < SDL_max(gWorkerCount, 1); ++i) SDL_SemPost(gAudioGate);
+}
+
+static AssetJob* Wait(const char* path, AssetKind kind) {
+    for (int i = 0; i < gJobCount; ++i) {
+        AssetJob& j = gJobs[i];
+        if (j.kind != kind || strcmp(j.path, path) != 0) continue;
+        if (!j.waited && j.done) {
+            // a sound waited for before the device was announced would block forever
+            if (kind == ASSET_SOUND && !gAudioSignalled) return nullptr;
+            SDL_SemWait(j.done);
+            j.waited = true;
+        }
+        return j.waited ? &j : nullptr;
+    }
+    return nullptr;
+}
+
+SDL_Surface* AssetSurface(const char* path) {
+    AssetJob* j = Wait(path, ASSET_IMAGE);
+    return j ? j->surface : nullptr;
+}
+
+Mix_Chunk* AssetTakeSound(const char* path) {
+    AssetJob* j = Wait(path, ASSET_SOUND);
+    if (!j) return nullptr;
+    Mix_Chunk* c = j->chunk;
+    j->chunk = nullptr;
+    return c;
+}
+
+TTF_Font* AssetTakeFont(const char* path) {
+    AssetJob* j = Wait(path, ASSET_FONT);
+    if (!j) return nullptr;
+    TTF_Font* f = j->font;
+    j->font = nullptr;
+    return f;
+}
+
+void AssetsQuit() {
+    AssetsAudioOpened(false);
+    for (int i = 0; i < gWorkerCount; ++i) SDL_WaitThread(gWorkers[i], nullptr);
+    gWorkerCount = 0;
+    for (int i = 0; i < gJobCount; ++i) {
+        AssetJob& j = gJobs[i];
+        if (j.surface) SDL_FreeSurface(j.surface);
+        if (j.chunk) Mix_FreeChunk(j.chunk);
+        if (j.font) TTF_CloseFont(j.font);
+        if (j.done) SDL_DestroySemaphore(j.done);
+    }
+    gJobCount = 0;
+    if (gAudioGate) SDL_DestroySemaphore(gAudioGate);
+    gAudioGate = nullptr;
+}
+
+void StartupMark(const char* what) {
+    Uint64 now = SDL_GetPerformanceCounter();
+    if (gMarkCount == 0) gStartupZero = now;
+    if (gMarkCount < (int)SDL_arraysize(gMarks)) gMarks[gMarkCount++] = StartupEvent{what, now};
+}
+
+static double StartupMs(Uint64 at) {
+    return (double)(at - gStartupZero) * 1000.0 / SDL_GetPerformanceFrequency();
+}
+
+void StartupLog() {
+    if (gStartupLogged || gMarkCount == 0) return;
+    gStartupLogged = true;
+    for (int i = 0; i < gMarkCount; ++i)
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "startup %7.1f ms  %s", StartupMs(gMarks[i].at), gMarks[i].what);
+    for (int i = 0; i < gJobCount; ++i) {
+        AssetJob& j = gJobs[i];
+        // jobs nobody waited for yet are only read once they are done
+        if (!j.waited && SDL_SemTryWait(j.done) == 0) j.waited = true;
+        if (!j.waited) continue;
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "startup %7.1f - %.1f ms  %s (worker %d)",
+                       StartupMs(j.start), StartupMs(j.end), j.path, j.worker);
+    }
+}
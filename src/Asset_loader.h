@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <SDL_ttf.h>
+
+// Startup assets decoded on a small thread pool while SDL opens the window
+// and the audio device. Decoding needs no renderer: images become surfaces
+// on the workers, loadTexture only uploads them on the main thread.
+// Mix_LoadWAV converts to the device format, so sound jobs wait until the
+// audio device is open. Queue everything, then AssetsStart; IMG_Init and
+// TTF_Init must be done before that.
+const int MAX_STARTUP_ASSETS = 16;
+
+void AssetQueueImage(const char* path);
+void AssetQueueSound(const char* path);
+void AssetQueueFont(const char* path, int size);
+void AssetsStart();
+// After Mix_OpenAudio, false when it failed.
+void AssetsAudioOpened(bool ok);
+// Decoded image of `path`, waits for its job; nullptr when it was not
+// queued or failed. The cache keeps it, so every game start reuses it.
+SDL_Surface* AssetSurface(const char* path);
+// Hands over a loaded chunk or font (the caller frees it), nullptr when it
+// was not queued, failed, or was taken already.
+Mix_Chunk* AssetTakeSound(const char* path);
+TTF_Font* AssetTakeFont(const char* path);
+// Waits for the workers and frees whatever nobody took.
+void AssetsQuit();
+
+// Startup timeline: marks from the first one on, logged together with the
+// job times by StartupLog (once, at the first menu frame).
+void StartupMark(const char* what);
+void StartupLog();
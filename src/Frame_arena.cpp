@@ -0,0 +1,121 @@
+#include <SDL.h>
+#include <atomic>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include "Frame_arena.h"
+
+alignas(64) static unsigned char gArena[FRAME_ARENA_SIZE];
+static size_t gArenaTop = 0;
+static size_t gArenaPeak = 0;
+
+void FrameReset() {
+    if (gArenaTop > gArenaPeak) gArenaPeak = gArenaTop;
+    gArenaTop = 0;
+}
+
+void* FrameAlloc(size_t bytes, size_t align) {
+    size_t start = (gArenaTop + align - 1) & ~(align - 1);
+    if (start + bytes > FRAME_ARENA_SIZE) {
+        // callers fall back to drawing without the arena, once is enough to know
+        static bool warned = false;
+        if (!warned) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                           "Frame arena full (%u bytes requested), further overflows are not logged", (unsigned)bytes);
+            warned = true;
+        }
+        return nullptr;
+    }
+    gArenaTop = start + bytes;
+    return gArena + start;
+}
+
+const char* FramePrintf(const char* fmt, ...) {
+    char* out = reinterpret_cast<char*>(gArena + gArenaTop);
+    size_t room = FRAME_ARENA_SIZE - gArenaTop;
+    if (room == 0) return "";
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vsnprintf(out, room, fmt, ap);
+    va_end(ap);
+    if (n < 0) return "";
+    gArenaTop += SDL_min((size_t)n + 1, room);
+    return out;
+}
+
+size_t FrameArenaUsed() {
+    return gArenaTop;
+}
+
+void FrameRewind(size_t top) {
+    if (gArenaTop > gArenaPeak) gArenaPeak = gArenaTop;
+    if (top < gArenaTop) gArenaTop = top;
+}
+
+static std::atomic<unsigned long long> gAllocs(0);
+static unsigned long long gSteadyFrames = 0, gSteadyAllocs = 0;
+
+#ifdef TRACK_ALLOCS
+void* operator new(size_t size) {
+    gAllocs.fetch_add(1, std::memory_order_relaxed);
+    if (size == 0) size = 1;
+    if (void* p = malloc(size)) return p;
+    throw std::bad_alloc();
+}
+void* operator new[](size_t size) { return operator new(size); }
+void operator delete(void* p) noexcept { free(p); }
+void operator delete[](void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+void operator delete[](void* p, size_t) noexcept { free(p); }
+
+bool AllocTrackingEnabled() { return true; }
+#else
+bool AllocTrackingEnabled() { return false; }
+#endif
+
+unsigned long long AllocCount() {
+    return gAllocs.load(std::memory_order_relaxed);
+}
+
+void AllocSteadyStats(unsigned long long& frames, unsigned long long& allocs) {
+    frames = gSteadyFrames;
+    allocs = gSteadyAllocs;
+}
+
+void AllocTrackFrame(const char* scene) {
+#ifdef TRACK_ALLOCS
+    static const char* current = nullptr;
+    static unsigned long long lastCount = 0, total = 0;
+    static unsigned frames = 0, worst = 0, sceneFrames = 0;
+    unsigned long long now = AllocCount();
+    unsigned thisFrame = (unsigned)(now - lastCount);
+    lastCount = now;
+    // a new scene starts a new summary, its first frame does the setup
+    if (current == nullptr || strcmp(current, scene) != 0) {
+        current = scene;
+        total = frames = worst = sceneFrames = 0;
+        return;
+    }
+    if (++sceneFrames > ALLOC_WARMUP_FRAMES) {
+        ++gSteadyFrames;
+        if (thisFrame && gSteadyAllocs < 1000) { // enough to find them, not a flood
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                           "%s: %u allocations in steady frame %u", scene, thisFrame, sceneFrames);
+        }
+        gSteadyAllocs += thisFrame;
+    }
+    ++frames;
+    total += thisFrame;
+    if (thisFrame > worst) worst = thisFrame;
+    if (frames == 300) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                       "%s: %llu allocations in %u frames (worst frame %u), frame arena peak %u bytes",
+                       scene, total, frames, worst, (unsigned)gArenaPeak);
+        total = frames = worst = 0;
+    }
+#else
+    (void)scene;
+#endif
+}
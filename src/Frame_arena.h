@@ -0,0 +1,30 @@
+#pragma once
+#include <cstddef>
+
+// Linear arena for data that only lives until the end of the current frame.
+// FrameReset() at the top of every frame loop releases everything at once.
+const size_t FRAME_ARENA_SIZE = 256 * 1024;
+
+void FrameReset();
+void* FrameAlloc(size_t bytes, size_t align = alignof(std::max_align_t));
+const char* FramePrintf(const char* fmt, ...);
+size_t FrameArenaUsed();
+// Releases what was allocated since FrameArenaUsed() returned `top`, for
+// scratch that is done with before the frame ends (a submitted batch).
+void FrameRewind(size_t top);
+
+template<class T> T* FrameAllocArray(size_t n) {
+    return static_cast<T*>(FrameAlloc(n * sizeof(T), alignof(T)));
+}
+
+// Allocation tracker. Build with TRACK_ALLOCS (the Debug target does) to
+// hook the global operator new; otherwise the counters stay at zero.
+bool AllocTrackingEnabled();
+unsigned long long AllocCount();
+// Call once per frame with the scene name; logs a summary every few seconds.
+void AllocTrackFrame(const char* scene);
+// Frames after the first ALLOC_WARMUP_FRAMES of each scene (caches fill,
+// first draws set up) are steady state and should not allocate at all.
+const unsigned ALLOC_WARMUP_FRAMES = 30;
+// Steady frames seen and the allocations they made, since the start.
+void AllocSteadyStats(unsigned long long& frames, unsigned long long& allocs);
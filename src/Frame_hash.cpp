@@ -0,0 +1,81 @@
+#include <cstdio>
+#include <cstring>
+#include "Frame_hash.h"
+using namespace std;
+
+static const Uint64 P1 = 11400714785074694791ULL, P2 = 14029467366897019727ULL,
+                    P3 = 1609587929392839161ULL, P4 = 9650029242287828579ULL,
+                    P5 = 2870177450012600261ULL;
+
+static inline Uint64 Rotl(Uint64 x, int r) { return (x << r) | (x >> (64 - r)); }
+
+static inline Uint64 Round(Uint64 acc, Uint64 in) {
+    acc += in * P2;
+    return Rotl(acc, 31) * P1;
+}
+
+static inline Uint64 Merge(Uint64 h, Uint64 v) {
+    h ^= Round(0, v);
+    return h * P1 + P4;
+}
+
+static inline Uint64 Load64(const Uint8* p) {
+    Uint64 v;
+    memcpy(&v, p, 8);
+    return v;
+}
+
+Uint64 FrameHash(const void* pixels, int pitch, int rowBytes, int rows) {
+    Uint64 v0 = P1 + P2, v1 = P2, v2 = 0, v3 = 0 - P1;
+    for (int y = 0; y < rows; ++y) {
+        const Uint8* p = (const Uint8*)pixels + (size_t)y * pitch;
+        int i = 0;
+        for (; i + 32 <= rowBytes; i += 32) {
+            v0 = Round(v0, Load64(p + i));
+            v1 = Round(v1, Load64(p + i + 8));
+            v2 = Round(v2, Load64(p + i + 16));
+            v3 = Round(v3, Load64(p + i + 24));
+        }
+        // the rest of the row, zero padded, into the first lanes
+        for (int k = 0; i < rowBytes; i += 8, ++k) {
+            Uint64 t = 0;
+            memcpy(&t, p + i, SDL_min(8, rowBytes - i));
+            Uint64& v = k == 0 ? v0 : k == 1 ? v1 : k == 2 ? v2 : v3;
+            v = Round(v, t);
+        }
+    }
+    Uint64 h = Rotl(v0, 1) + Rotl(v1, 7) + Rotl(v2, 12) + Rotl(v3, 18);
+    h = Merge(Merge(Merge(Merge(h, v0), v1), v2), v3);
+    h += (Uint64)rowBytes * rows;
+    // final avalanche
+    h ^= h >> 33; h *= P2;
+    h ^= h >> 29; h *= P3;
+    h ^= h >> 32;
+    return h ^ P5;
+}
+
+bool GoldenLoad(const char* path, map<string, Uint64>& out) {
+    FILE* f = fopen(path, "r");
+    if (!f) return false;
+    char line[256];
+    while (fgets(line, sizeof(line), f)) {
+        char* end = line + strcspn(line, "\r\n");
+        *end = 0;
+        char* sp = strrchr(line, ' ');
+        if (!sp || line[0] == '#') continue;
+        *sp = 0;
+        unsigned long long h;
+        if (sscanf(sp + 1, "%llx", &h) == 1) out[line] = h;
+    }
+    fclose(f);
+    return true;
+}
+
+bool GoldenSave(const char* path, const map<string, Uint64>& hashes) {
+    FILE* f = fopen(path, "w");
+    if (!f) return false;
+    fprintf(f, "# render check golden frames, written by --render-check FILE --update\n");
+    for (const auto& kv : hashes) fprintf(f, "%s %016llx\n", kv.first.c_str(), (unsigned long long)kv.second);
+    fclose(f);
+    return true;
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <SDL.h>
+#include <map>
+#include <string>
+
+// 64-bit frame hash: xxHash64 rounds in four lanes over each row. Only
+// `rowBytes` of every row count, so pitch padding never changes the hash.
+Uint64 FrameHash(const void* pixels, int pitch, int rowBytes, int rows);
+
+// Golden hash files, one "name hash" line per frame, the hash as 16 hex
+// digits. The name may contain spaces, the hash is the last word.
+bool GoldenLoad(const char* path, std::map<std::string, Uint64>& out);
+bool GoldenSave(const char* path, const std::map<std::string, Uint64>& hashes);
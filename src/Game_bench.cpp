@@ -0,0 +1,183 @@
+#include <iostream>
+#include <chrono>
+#include "Game_rules.h"
+#include "Game_bench.h"
+#include "Game_history.h"
+#include "Frame_arena.h"
+#include "Snake_env.h"
+#include "Timer_wheel.h"
+using namespace std;
+
+template<class Mode, class B> static void BenchMode(int ticks) {
+    const size_t maxLen = B::cells / 2; // keep a free area so food placement stays cheap
+    GameState s;
+    NewGame<Mode, B>(s);
+    int eaten = 0, restarts = 0;
+    long long sumLen = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int i = 0; i < ticks; ++i) {
+        s.nextDir = AutopilotDir<B>(s.snake.front());
+        TickResult r = Tick<Mode, B>(s);
+        if (r == TICK_ATE) ++eaten;
+        if (r == TICK_DIED || s.snake.size() >= maxLen) {
+            NewGame<Mode, B>(s);
+            ++restarts;
+        }
+        sumLen += s.snake.size();
+    }
+    double ns = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+    cout << Mode::Name() << " " << B::cols << "x" << B::rows << ": " << ns/ticks << " ns/tick over " << ticks << " ticks"
+         << " (avg length " << sumLen/ticks << ", eaten " << eaten << ", restarts " << restarts << ")" << endl;
+}
+
+int RunTickBenchmark(int ticks) {
+    if (ticks <= 0) ticks = 1000000;
+    srand(12345);
+    BenchMode<ClassicMode, ScreenBoard>(ticks);
+    srand(12345);
+    BenchMode<TwoLayerMode, ScreenBoard>(ticks);
+    srand(12345);
+    BenchMode<FeastMode, ScreenBoard>(ticks);
+    srand(12345);
+    BenchMode<PowerUpMode, ScreenBoard>(ticks);
+    // the other board sizes the game can be started with
+    srand(12345);
+    BenchMode<ClassicMode, Board<20,20> >(ticks);
+    srand(12345);
+    BenchMode<ClassicMode, Board<64,64> >(ticks);
+    srand(12345);
+    BenchMode<ClassicMode, Board<128,128> >(ticks);
+    return 0;
+}
+
+template<class Mode, class B> static unsigned long long AllocCheckMode(int ticks) {
+    GameState s;
+    History h;
+    NewGame<Mode, B>(s);
+    HistoryReset(h, s, B::cells + 1);
+    unsigned long long bad = 0;
+    for (int i = 0; i < ticks; ++i) {
+        FrameReset();
+        s.nextDir = AutopilotDir<B>(s.snake.front());
+        unsigned long long before = AllocCount();
+        TickResult r = Tick<Mode, B>(s);
+        if (Mode::CanRewind() && r != TICK_DIED) {
+            HistoryRecord(h, s);
+            if (i % 100 == 99) HistoryRewindTo(h, s, h.tick - 40);
+        }
+        FramePrintf("Score: %d", s.score);
+        bad += AllocCount() - before;
+        // a restart is a new game, not steady state
+        if (r == TICK_DIED || s.snake.size() >= (size_t)B::cells / 2) {
+            NewGame<Mode, B>(s);
+            HistoryReset(h, s, B::cells + 1);
+        }
+    }
+    cout << Mode::Name() << " " << B::cols << "x" << B::rows << ": " << bad << " heap allocations in " << ticks << " ticks" << endl;
+    return bad;
+}
+
+const int ENV_BENCH_GAMES = 1024;
+
+// Random actions, a new set each step, one of them out of range.
+static void RandomActions(vector<unsigned char>& actions, unsigned& seed) {
+    for (unsigned char& a : actions) {
+        seed = seed * 1664525u + 1013904223u;
+        a = seed >> 30;
+    }
+    actions[seed % actions.size()] = 255;
+}
+
+static unsigned long long AllocCheckEnv(int ticks) {
+    const int games = 64;
+    SnakeEnv* env = SnakeEnvCreate(games, ScreenBoard::cols, ScreenBoard::rows, 12345);
+    vector<unsigned char> actions(games), dones(games);
+    vector<float> rewards(games);
+    unsigned seed = 1;
+    unsigned long long bad = 0;
+    for (int i = 0; i < ticks / games; ++i) {
+        RandomActions(actions, seed);
+        unsigned long long before = AllocCount();
+        SnakeEnvStep(env, actions.data(), rewards.data(), dones.data());
+        bad += AllocCount() - before;
+    }
+    SnakeEnvDestroy(env);
+    cout << "Snake_env: " << bad << " heap allocations in " << ticks / games * games << " env steps" << endl;
+    return bad;
+}
+
+int RunAllocCheck(int ticks) {
+    if (!AllocTrackingEnabled()) {
+        cerr << "Built without TRACK_ALLOCS, use the Debug target" << endl;
+        return 2;
+    }
+    if (ticks <= 0) ticks = 100000;
+    srand(12345);
+    unsigned long long bad = AllocCheckMode<ClassicMode, ScreenBoard>(ticks);
+    bad += AllocCheckMode<TwoLayerMode, ScreenBoard>(ticks);
+    bad += AllocCheckMode<FeastMode, ScreenBoard>(ticks);
+    bad += AllocCheckMode<FeastMode, Board<128,128> >(ticks);
+    bad += AllocCheckMode<PowerUpMode, ScreenBoard>(ticks);
+    bad += AllocCheckEnv(ticks);
+    return bad == 0 ? 0 : 1;
+}
+
+int RunEnvBenchmark(int steps) {
+    if (steps <= 0) steps = 10000;
+    SnakeEnv* env = SnakeEnvCreate(ENV_BENCH_GAMES, ScreenBoard::cols, ScreenBoard::rows, 12345);
+    vector<unsigned char> actions(ENV_BENCH_GAMES), dones(ENV_BENCH_GAMES);
+    vector<float> rewards(ENV_BENCH_GAMES);
+    unsigned seed = 1;
+    long long ends = 0, eaten = 0;
+    double ns = 0;
+    for (int i = 0; i < steps; ++i) {
+        RandomActions(actions, seed);
+        auto t0 = chrono::steady_clock::now();
+        SnakeEnvStep(env, actions.data(), rewards.data(), dones.data());
+        ns += chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+        for (int e = 0; e < ENV_BENCH_GAMES; ++e) {
+            ends += dones[e];
+            eaten += rewards[e] > 0;
+        }
+    }
+    double total = (double)steps * ENV_BENCH_GAMES;
+    cout << "Snake_env " << ENV_BENCH_GAMES << " x " << ScreenBoard::cols << "x" << ScreenBoard::rows << ": "
+         << total / ns * 1e3 << " M env steps/s, " << ns / total << " ns/step"
+         << " (games ended " << ends << ", eaten " << eaten << ")" << endl;
+    SnakeEnvDestroy(env);
+    return 0;
+}
+
+// Every fired timer goes back in, so the pending count stays put.
+static void BenchTimers(int pending, int ticks) {
+    const int spread = 10000; // ticks ahead a timer is set for
+    TimerWheel w;
+    TimerReset(w, pending);
+    for (int i = 0; i < pending; ++i) TimerAdd(w, 1 + rand() % spread, i);
+    long long fired = 0;
+    auto t0 = chrono::steady_clock::now();
+    for (int t = 1; t <= ticks; ++t) {
+        for (int d; (d = TimerPop(w, t)) >= 0; ++fired) TimerAdd(w, t + 1 + rand() % spread, d);
+    }
+    double wheelNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+
+    // the same load as a list scanned every tick, over fewer ticks when it is long
+    vector<unsigned long long> due(pending);
+    for (int i = 0; i < pending; ++i) due[i] = 1 + rand() % spread;
+    int scanTicks = (int)min<long long>(ticks, 200000000LL / pending + 1);
+    t0 = chrono::steady_clock::now();
+    for (int t = 1; t <= scanTicks; ++t) {
+        for (int i = 0; i < pending; ++i)
+            if (due[i] <= (unsigned long long)t) due[i] = t + 1 + rand() % spread;
+    }
+    double scanNs = chrono::duration<double, nano>(chrono::steady_clock::now() - t0).count();
+    cout << pending << " timers pending: wheel " << wheelNs / ticks << " ns/tick (" << (double)fired / ticks
+         << " fired per tick), scan " << scanNs / scanTicks << " ns/tick" << endl;
+}
+
+int RunTimerBenchmark(int ticks) {
+    if (ticks <= 0) ticks = 1000000;
+    srand(12345);
+    for (int pending : {10, 1000, 10000, 100000}) BenchTimers(pending, ticks);
+    return 0;
+}
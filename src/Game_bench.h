@@ -0,0 +1,9 @@
+#pragma once
+int RunTickBenchmark(int ticks);
+// Runs the tick loop (with rewind history where the mode has it) and fails
+// when a steady-state tick hits operator new.
+int RunAllocCheck(int ticks);
+// Steps a batch of Snake_env games with random actions, reports env steps/s.
+int RunEnvBenchmark(int steps);
+// Timing wheel against a scanned list with 10 to 100000 timers pending.
+int RunTimerBenchmark(int ticks);
@@ -0,0 +1,80 @@
+#include "Game_history.h"
+
+static void SaveKeyframe(History& h, const GameState& s) {
+    int slot = (int)(h.tick / HISTORY_KEYFRAME % HISTORY_KEYS);
+    Keyframe& k = h.keys[slot];
+    k.tick = h.tick;
+    k.len = (int)s.snake.size();
+    k.dir = s.dir;
+    k.food = s.food;
+    k.fake = s.fake;
+    k.fakePassed = s.fakePassed;
+    k.fakeIsFood = s.fakeIsFood;
+    k.score = s.score;
+    std::copy(s.snake.begin(), s.snake.end(), h.keySnakes.begin() + slot * h.stride);
+}
+
+void HistoryReset(History& h, const GameState& s, int maxLen) {
+    h.deltas.resize(HISTORY_TICKS);
+    h.keys.resize(HISTORY_KEYS);
+    h.stride = maxLen;
+    h.keySnakes.resize(HISTORY_KEYS * maxLen);
+    h.tick = 0;
+    h.len = s.snake.size();
+    SaveKeyframe(h, s);
+}
+
+void HistoryRecord(History& h, const GameState& s) {
+    if (h.deltas.empty()) return;
+    TickDelta& d = h.deltas[h.tick % HISTORY_TICKS];
+    d.head = s.snake.front();
+    d.food = s.food;
+    d.fake = s.fake;
+    d.dir = s.dir;
+    d.score = s.score;
+    // the head was added either way, so an unchanged length means the tail left
+    d.flags = (s.snake.size() == h.len ? DELTA_TAIL_LEFT : 0)
+            | (s.fakePassed ? DELTA_FAKE_PASSED : 0)
+            | (s.fakeIsFood ? DELTA_FAKE_IS_FOOD : 0);
+    h.len = s.snake.size();
+    ++h.tick;
+    if (h.tick % HISTORY_KEYFRAME == 0) SaveKeyframe(h, s);
+}
+
+unsigned long long HistoryOldest(const History& h) {
+    // a keyframe is only usable while every delta after it is still in the ring
+    unsigned long long first = h.tick > HISTORY_TICKS ? h.tick - HISTORY_TICKS : 0;
+    return (first + HISTORY_KEYFRAME - 1) / HISTORY_KEYFRAME * HISTORY_KEYFRAME;
+}
+
+int HistoryRewindTo(History& h, GameState& s, unsigned long long target) {
+    if (h.deltas.empty()) return 0;
+    target = std::max(target, HistoryOldest(h));
+    if (target >= h.tick) return 0;
+    int slot = (int)(target / HISTORY_KEYFRAME % HISTORY_KEYS);
+    const Keyframe& k = h.keys[slot];
+    const Point* snake = &h.keySnakes[slot * h.stride];
+    s.snake.assign(snake, snake + k.len);
+    s.dir = k.dir;
+    s.food = k.food;
+    s.fake = k.fake;
+    s.fakePassed = k.fakePassed;
+    s.fakeIsFood = k.fakeIsFood;
+    s.score = k.score;
+    for (unsigned long long t = k.tick + 1; t <= target; ++t) {
+        const TickDelta& d = h.deltas[(t - 1) % HISTORY_TICKS];
+        s.snake.insert(s.snake.begin(), d.head);
+        if (d.flags & DELTA_TAIL_LEFT) s.snake.pop_back();
+        s.dir = d.dir;
+        s.food = d.food;
+        s.fake = d.fake;
+        s.fakePassed = (d.flags & DELTA_FAKE_PASSED) != 0;
+        s.fakeIsFood = (d.flags & DELTA_FAKE_IS_FOOD) != 0;
+        s.score = d.score;
+    }
+    s.nextDir = s.dir;
+    int undone = (int)(h.tick - target);
+    h.tick = target;
+    h.len = s.snake.size();
+    return undone;
+}
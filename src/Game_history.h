@@ -0,0 +1,48 @@
+#pragma once
+#include <vector>
+#include "Game_rules.h"
+
+// Rewind history: one small delta per tick in a fixed ring, plus a full
+// snapshot every HISTORY_KEYFRAME ticks. Going back restores the keyframe
+// at or before the target and replays at most HISTORY_KEYFRAME-1 deltas,
+// so the cost does not depend on how far back we go. Everything is
+// allocated by HistoryReset, recording never allocates.
+const int HISTORY_TICKS    = 1024;
+const int HISTORY_KEYFRAME = 32;
+const int HISTORY_KEYS     = HISTORY_TICKS / HISTORY_KEYFRAME + 1;
+
+// What one tick changed: head added, tail removed or not, where the food
+// and fake ended up.
+enum { DELTA_TAIL_LEFT = 1, DELTA_FAKE_PASSED = 2, DELTA_FAKE_IS_FOOD = 4 };
+struct TickDelta {
+    Point head, food, fake, dir;
+    int score;
+    unsigned char flags;
+};
+
+struct Keyframe {
+    unsigned long long tick;
+    int len;
+    Point dir, food, fake;
+    bool fakePassed, fakeIsFood;
+    int score;
+};
+
+struct History {
+    std::vector<TickDelta> deltas; // tick t is in slot (t-1) % HISTORY_TICKS
+    std::vector<Keyframe> keys;    // tick t (t % HISTORY_KEYFRAME == 0) in slot t / HISTORY_KEYFRAME % HISTORY_KEYS
+    std::vector<Point> keySnakes;  // `stride` points per keyframe
+    int stride = 0;                // longest snake the board allows
+    unsigned long long tick = 0;   // ticks recorded since the reset
+    size_t len = 0;                // snake length after the last recorded tick
+};
+
+// maxLen: cells of the board plus one, it sizes the keyframes.
+void HistoryReset(History& h, const GameState& s, int maxLen = BOARD_CELLS + 1);
+// Call after every tick the snake survived.
+void HistoryRecord(History& h, const GameState& s);
+// Oldest tick that can still be restored.
+unsigned long long HistoryOldest(const History& h);
+// Puts `s` back to tick `target` (clamped to what is stored) and drops the
+// ticks after it. Returns how many ticks were undone.
+int HistoryRewindTo(History& h, GameState& s, unsigned long long target);
@@ -0,0 +1,474 @@
+#pragma once
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include "Level_pack.h"
+#include "Timer_wheel.h"
+
+const int SCREEN_WIDTH  = 600;
+const int SCREEN_HEIGHT = 800;
+const int RECT_SIZE     = 20;
+
+struct Point {
+    int x, y;
+    constexpr Point(int x_val, int y_val) : x(x_val), y(y_val) {}
+    constexpr Point() : x(0), y(0) {}
+    constexpr bool operator==(const Point& o) const { return x==o.x && y==o.y; }
+};
+
+// Board geometry as a type, so indexing, neighbours and bounds checks are
+// constant expressions in each instantiation. Points are in board units,
+// RECT_SIZE per cell; the native board covers the window exactly.
+template<int COLS, int ROWS> struct Board {
+    enum { cols = COLS, rows = ROWS, cells = COLS*ROWS, width = COLS*RECT_SIZE, height = ROWS*RECT_SIZE,
+           native = COLS == SCREEN_WIDTH/RECT_SIZE && ROWS == SCREEN_HEIGHT/RECT_SIZE };
+    static constexpr bool Inside(const Point& p) { return p.x >= 0 && p.x < width && p.y >= 0 && p.y < height; }
+    static constexpr int Index(const Point& p) { return (p.y/RECT_SIZE)*COLS + p.x/RECT_SIZE; }
+    static constexpr Point Next(const Point& p, const Point& dir) { return Point(p.x + dir.x, p.y + dir.y); }
+};
+typedef Board<SCREEN_WIDTH/RECT_SIZE, SCREEN_HEIGHT/RECT_SIZE> ScreenBoard;
+
+const int BOARD_CELLS = ScreenBoard::cells;
+
+// Cell of the native board (levels, renderer caches).
+inline int CellIndex(const Point& p) {
+    return ScreenBoard::Index(p);
+}
+
+// Feast mode items, looked up through GameState::cellItem.
+enum FeastKind { FEAST_NORMAL, FEAST_FAKE, FEAST_BONUS };
+struct FeastItem {
+    Point p;
+    unsigned char kind;
+    bool passed; // fake items turn real once crossed
+};
+const int FEAST_ITEMS = 200;
+
+// Power-Up mode items, see PowerUpMode.
+enum PowerKind { POWER_SPEED, POWER_SLOW, POWER_SHRINK, POWER_GHOST, POWER_KINDS };
+struct PowerItem {
+    Point p;
+    int kind = -1; // -1 while the slot is empty
+    TimerId vanish = 0;
+};
+const int POWER_SLOTS        = 4;   // items on the board at once
+const int POWER_SPAWN_TICKS  = 40;  // between items, plus up to as much again at random
+const int POWER_LIFE_TICKS   = 120; // an item nobody takes vanishes after this
+const int POWER_EFFECT_TICKS = 100; // speed, slow motion and ghost last this long
+const int FOOD_LIFE_TICKS    = 200; // food left alone moves elsewhere
+
+// Everything a running game needs, so it can be saved for "Resume Game".
+struct GameState {
+    std::vector<Point> snake;
+    Point dir, nextDir, food, fake;
+    bool fakePassed = false;
+    bool fakeIsFood = false;
+    int score = 0;
+    unsigned long long last = 0; // us, time of the last simulated tick
+    unsigned interval = 150000;  // us between ticks
+    std::vector<FeastItem> items;
+    std::vector<short> cellItem; // board cell -> index in items, -1 if empty
+    const unsigned char* walls = nullptr; // level collision mask, mapped from the pack
+    int wallCount = 0;
+    // Power-Up mode: everything timed runs on the wheel, keyed by `tick`
+    TimerWheel timers;
+    unsigned long long tick = 0;
+    PowerItem power[POWER_SLOTS];
+    TimerId effect[POWER_KINDS] = {}; // end of a running effect, 0 when off
+    TimerId foodTimer = 0;
+};
+
+// Time between ticks once the Power-Up effects are applied.
+inline unsigned TickInterval(const GameState& s) {
+    if (s.effect[POWER_SPEED]) return s.interval / 2;
+    if (s.effect[POWER_SLOW]) return s.interval * 2;
+    return s.interval;
+}
+
+// Difficulty curve of the turbo/stress mode: each food makes ticks 10%
+// faster, from 20 ms down to 250 us.
+const unsigned TURBO_START_US = 20000;
+const unsigned TURBO_MIN_US   = 250;
+inline unsigned TurboInterval(int score) {
+    double us = TURBO_START_US * pow(0.9, score / 10);
+    return us < TURBO_MIN_US ? TURBO_MIN_US : (unsigned)us;
+}
+
+enum TickResult { TICK_MOVED, TICK_ATE, TICK_DIED };
+
+inline bool OnSnake(const GameState& s, const Point& p) {
+    return std::find(s.snake.begin(), s.snake.end(), p) != s.snake.end();
+}
+
+// Levels are only made for the native board, see NewGame.
+template<class B = ScreenBoard> bool OnWall(const GameState& s, const Point& p) {
+    return s.walls && LevelBit(s.walls, B::Index(p));
+}
+
+// Cells new items may not be put on.
+template<class B = ScreenBoard> bool Occupied(const GameState& s, const Point& p) {
+    return OnWall<B>(s, p) || OnSnake(s, p);
+}
+
+template<class B = ScreenBoard> void RandomCell(Point& p) {
+    p.x = (rand()%B::cols)*RECT_SIZE;
+    p.y = (rand()%B::rows)*RECT_SIZE;
+}
+
+// Autopilot that walks a Hamiltonian cycle over the board (column 0 is the
+// way back up), so it never dies; used by turbo runs and benchmarks.
+template<class B = ScreenBoard> Point AutopilotDir(const Point& head) {
+    static_assert(B::rows % 2 == 0, "the autopilot cycle needs an even row count");
+    int x = head.x/RECT_SIZE, y = head.y/RECT_SIZE;
+    if (x == 0) return y == 0 ? Point(RECT_SIZE, 0) : Point(0, -RECT_SIZE);
+    if (y % 2 == 0) return x < B::cols-1 ? Point(RECT_SIZE, 0) : Point(0, RECT_SIZE);
+    if (x > 1 || y == B::rows-1) return Point(-RECT_SIZE, 0);
+    return Point(0, RECT_SIZE);
+}
+
+// Mode policies. Each one only holds the rules that differ from Classic,
+// the shared tick below is instantiated once per policy and board so no
+// mode pays for the checks of another one.
+struct ClassicMode {
+    static const char* Name() { return "Classic"; }
+    // free cells the mode needs besides the snake
+    static int Reserved() { return 1; }
+    template<class B> static bool Blocks(const GameState&, const Point&) { return false; }
+    // the rewind history (Game_history.h) covers everything the mode changes
+    static bool CanRewind() { return true; }
+    // true while the snake may cross its own body
+    static bool Ghost(const GameState&) { return false; }
+    template<class B> static void Start(GameState&) {}
+    // returns true when the snake keeps its tail (grows) this tick
+    template<class B> static bool Arrive(GameState&, const Point&, TickResult&) { return false; }
+    // after every tick the snake survived
+    template<class B> static void Update(GameState&, TickResult) {}
+};
+
+// Two-Layer: the fake food must be crossed once before it turns real.
+struct TwoLayerMode {
+    static const char* Name() { return "Two-Layer"; }
+    static int Reserved() { return 2; }
+    template<class B> static bool Blocks(const GameState& s, const Point& p) { return p == s.fake; }
+    static bool CanRewind() { return true; }
+    static bool Ghost(const GameState&) { return false; }
+    template<class B> static void Update(GameState&, TickResult) {}
+    template<class B> static void PlaceFake(GameState& s) {
+        do { RandomCell<B>(s.fake); } while (Occupied<B>(s, s.fake) || s.fake == s.food);
+    }
+    template<class B> static void Start(GameState& s) {
+        s.fakePassed = false;
+        s.fakeIsFood = false;
+        PlaceFake<B>(s);
+    }
+    template<class B> static bool Arrive(GameState& s, const Point& head, TickResult& r) {
+        if (!(head == s.fake)) return false;
+        if (!s.fakePassed) {
+            s.fakePassed = true;
+            s.fakeIsFood = true;
+        } else {
+            PlaceFake<B>(s);
+            s.fakePassed = false;
+            s.fakeIsFood = false;
+            s.score += 20;
+            r = TICK_ATE;
+        }
+        return true;
+    }
+};
+
+// Feast: hundreds of items of several kinds. Arrival and respawn go through
+// the cell table, so they cost the same whatever the item count.
+struct FeastMode {
+    static const char* Name() { return "Feast"; }
+    static int Reserved() { return FEAST_ITEMS + 1; }
+    template<class B> static bool Blocks(const GameState& s, const Point& p) {
+        return !s.cellItem.empty() && s.cellItem[B::Index(p)] >= 0;
+    }
+    static bool CanRewind() { return false; } // the items are not in the history
+    static bool Ghost(const GameState&) { return false; }
+    template<class B> static void Update(GameState&, TickResult) {}
+    template<class B> static void Place(GameState& s, int i) {
+        FeastItem& it = s.items[i];
+        do { RandomCell<B>(it.p); } while (s.cellItem[B::Index(it.p)] >= 0 || it.p == s.food || Occupied<B>(s, it.p));
+        s.cellItem[B::Index(it.p)] = i;
+        it.passed = false;
+    }
+    template<class B> static void Start(GameState& s) {
+        s.cellItem.assign(B::cells, -1);
+        s.items.resize(FEAST_ITEMS);
+        for (int i = 0; i < FEAST_ITEMS; ++i) {
+            s.items[i].kind = i % 10 == 0 ? FEAST_BONUS : i % 3 == 0 ? FEAST_FAKE : FEAST_NORMAL;
+            Place<B>(s, i);
+        }
+    }
+    template<class B> static bool Arrive(GameState& s, const Point& head, TickResult& r) {
+        int i = s.cellItem[B::Index(head)];
+        if (i < 0) return false;
+        FeastItem& it = s.items[i];
+        if (it.kind == FEAST_FAKE && !it.passed) {
+            it.passed = true;
+            return true;
+        }
+        s.score += it.kind == FEAST_BONUS ? 50 : it.kind == FEAST_FAKE ? 20 : 10;
+        r = TICK_ATE;
+        s.cellItem[B::Index(head)] = -1;
+        Place<B>(s, i);
+        return true;
+    }
+};
+
+// No room left for the snake to grow into and the mode's items.
+template<class Mode, class B = ScreenBoard> bool BoardFull(const GameState& s) {
+    return (int)s.snake.size() + s.wallCount + Mode::Reserved() + 1 >= B::cells;
+}
+
+template<class Mode, class B = ScreenBoard> void PlaceFood(GameState& s) {
+    do { RandomCell<B>(s.food); } while (Occupied<B>(s, s.food) || Mode::template Blocks<B>(s, s.food));
+}
+
+// Power-Up: Classic plus timed items. Speed boost and slow motion change
+// the tick rate, shrink halves the snake, ghost lets it cross itself. Items
+// appear and vanish, effects wear off and uneaten food moves, all through
+// timers on the state's wheel, so a tick only pays for what is due.
+struct PowerUpMode {
+    // timer payload: event in the low byte, item slot or effect kind above
+    enum { EV_SPAWN, EV_VANISH, EV_EFFECT_END, EV_FOOD };
+    static const char* Name() { return "Power-Up"; }
+    static int Reserved() { return POWER_SLOTS + 1; }
+    template<class B> static bool Blocks(const GameState& s, const Point& p) { return ItemAt(s, p) >= 0; }
+    static bool CanRewind() { return false; } // effects and timers are not in the history
+    static bool Ghost(const GameState& s) { return s.effect[POWER_GHOST] != 0; }
+    static int ItemAt(const GameState& s, const Point& p) {
+        for (int i = 0; i < POWER_SLOTS; ++i) if (s.power[i].kind >= 0 && s.power[i].p == p) return i;
+        return -1;
+    }
+    static TimerId Schedule(GameState& s, int ticks, int event, int arg = 0) {
+        return TimerAdd(s.timers, s.tick + ticks, event | arg << 8);
+    }
+    static void EndEffect(GameState& s, int kind) {
+        TimerCancel(s.timers, s.effect[kind]);
+        s.effect[kind] = 0;
+    }
+    template<class B> static void Spawn(GameState& s) {
+        int i = 0;
+        while (i < POWER_SLOTS && s.power[i].kind >= 0) ++i;
+        if (i == POWER_SLOTS || BoardFull<PowerUpMode, B>(s)) return;
+        PowerItem& it = s.power[i];
+        do { RandomCell<B>(it.p); } while (Occupied<B>(s, it.p) || it.p == s.food || ItemAt(s, it.p) >= 0);
+        it.kind = rand() % POWER_KINDS;
+        it.vanish = Schedule(s, POWER_LIFE_TICKS, EV_VANISH, i);
+    }
+    template<class B> static void Start(GameState& s) {
+        // every timer the mode can have pending at once: spawn, food, one
+        // per item and per effect (speed and slow motion exclude each other)
+        TimerReset(s.timers, 2 + POWER_SLOTS + POWER_KINDS - 1);
+        s.foodTimer = Schedule(s, FOOD_LIFE_TICKS, EV_FOOD);
+        Schedule(s, POWER_SPAWN_TICKS, EV_SPAWN);
+    }
+    template<class B> static bool Arrive(GameState& s, const Point& head, TickResult&) {
+        int i = ItemAt(s, head);
+        if (i < 0) return false;
+        PowerItem& it = s.power[i];
+        TimerCancel(s.timers, it.vanish);
+        int kind = it.kind;
+        it.kind = -1;
+        if (kind == POWER_SHRINK) {
+            // Tick still drops the tail after this, the snake keeps at least its head
+            s.snake.resize(std::max<size_t>(2, s.snake.size() / 2));
+            return false;
+        }
+        // taking one again starts it over; speed and slow motion cancel each other
+        if (kind == POWER_SPEED) EndEffect(s, POWER_SLOW);
+        if (kind == POWER_SLOW) EndEffect(s, POWER_SPEED);
+        EndEffect(s, kind);
+        s.effect[kind] = Schedule(s, POWER_EFFECT_TICKS, EV_EFFECT_END, kind);
+        return false;
+    }
+    template<class B> static void Update(GameState& s, TickResult r) {
+        ++s.tick;
+        // Tick placed new food, it gets its full time
+        if (r == TICK_ATE) {
+            TimerCancel(s.timers, s.foodTimer);
+            s.foodTimer = Schedule(s, FOOD_LIFE_TICKS, EV_FOOD);
+        }
+        for (int ev; (ev = TimerPop(s.timers, s.tick)) >= 0; ) {
+            int arg = ev >> 8;
+            switch (ev & 0xff) {
+            case EV_SPAWN:
+                Spawn<B>(s);
+                Schedule(s, POWER_SPAWN_TICKS + rand() % POWER_SPAWN_TICKS, EV_SPAWN);
+                break;
+            case EV_VANISH:
+                s.power[arg].kind = -1;
+                break;
+            case EV_EFFECT_END:
+                s.effect[arg] = 0;
+                break;
+            case EV_FOOD:
+                PlaceFood<PowerUpMode, B>(s);
+                s.foodTimer = Schedule(s, FOOD_LIFE_TICKS, EV_FOOD);
+                break;
+            }
+        }
+    }
+};
+
+// Levels only fit the native board, other boards ignore `level`.
+template<class Mode, class B = ScreenBoard> void NewGame(GameState& s, const Level* level = nullptr) {
+    s = GameState();
+    if (level && B::native) {
+        s.walls = level->bits;
+        s.wallCount = level->wallCount;
+    }
+    s.dir = s.nextDir = Point(RECT_SIZE, 0);
+    // the snake can never outgrow the board, so ticks never reallocate
+    s.snake.reserve(B::cells + 1);
+    s.snake.emplace_back(B::width/2/RECT_SIZE*RECT_SIZE, B::height/2/RECT_SIZE*RECT_SIZE);
+    PlaceFood<Mode, B>(s);
+    Mode::template Start<B>(s);
+}
+
+// One simulation step. Sounds and rendering are left to the caller.
+template<class Mode, class B = ScreenBoard> TickResult Tick(GameState& s) {
+    s.dir = s.nextDir;
+    Point head = B::Next(s.snake.front(), s.dir);
+    // boundary check
+    if (!B::Inside(head)) return TICK_DIED;
+    if (OnWall<B>(s, head) || (OnSnake(s, head) && !Mode::Ghost(s))) return TICK_DIED;
+    s.snake.insert(s.snake.begin(), head);
+    TickResult r = TICK_MOVED;
+    if (head == s.food) {
+        PlaceFood<Mode, B>(s);
+        s.score += 10;
+        r = TICK_ATE;
+    }
+    else if (!Mode::template Arrive<B>(s, head, r)) {
+        s.snake.pop_back();
+    }
+    Mode::template Update<B>(s, r);
+    return r;
+}
+
+// Versus: two players on the one keyboard, WASD and the arrow keys. The
+// rules come as policies like the modes above: VersusSplit gives each
+// player a Classic game on a board half the window wide, VersusShared puts
+// both snakes on one board wider than the window, chasing the same food.
+const int VERSUS_PLAYERS = 2;
+typedef Board<SCREEN_WIDTH/RECT_SIZE/2, SCREEN_HEIGHT/RECT_SIZE> SplitBoard;
+typedef Board<SCREEN_WIDTH/RECT_SIZE*4/3, SCREEN_HEIGHT/RECT_SIZE> SharedBoard;
+
+struct VersusGame {
+    GameState p[VERSUS_PLAYERS]; // on the shared board the food is p[0].food
+};
+
+struct VersusSplit {
+    static const char* Name() { return "Versus Split"; }
+    static bool Shared() { return false; }
+    template<class B> static void Start(VersusGame& v) {
+        for (GameState& s : v.p) NewGame<ClassicMode, B>(s);
+    }
+    template<class B> static void Tick(VersusGame& v, TickResult r[VERSUS_PLAYERS]) {
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) r[i] = ::Tick<ClassicMode, B>(v.p[i]);
+    }
+    template<class B> static bool Full(const VersusGame& v) {
+        return BoardFull<ClassicMode, B>(v.p[0]) || BoardFull<ClassicMode, B>(v.p[1]);
+    }
+};
+
+struct VersusShared {
+    static const char* Name() { return "Versus Shared"; }
+    static bool Shared() { return true; }
+    static bool OnSnakes(const VersusGame& v, const Point& p) { return OnSnake(v.p[0], p) || OnSnake(v.p[1], p); }
+    template<class B> static void PlaceFood(VersusGame& v) {
+        do { RandomCell<B>(v.p[0].food); } while (OnSnakes(v, v.p[0].food));
+    }
+    template<class B> static void Start(VersusGame& v) {
+        for (GameState& s : v.p) {
+            s = GameState();
+            s.snake.reserve(B::cells + 1);
+        }
+        // on different rows and heading apart, nobody dies before the first key
+        v.p[0].snake.emplace_back(B::cols/4*RECT_SIZE, B::rows/3*RECT_SIZE);
+        v.p[1].snake.emplace_back(B::cols*3/4*RECT_SIZE, B::rows*2/3*RECT_SIZE);
+        v.p[0].dir = v.p[0].nextDir = Point(-RECT_SIZE, 0);
+        v.p[1].dir = v.p[1].nextDir = Point(RECT_SIZE, 0);
+        PlaceFood<B>(v);
+    }
+    // Both heads move at once: a head dies on the walls, on either snake as
+    // it was before the tick, or on the other head. Once someone died
+    // nothing moves any more.
+    template<class B> static void Tick(VersusGame& v, TickResult r[VERSUS_PLAYERS]) {
+        Point head[VERSUS_PLAYERS];
+        bool died = false;
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            GameState& s = v.p[i];
+            s.dir = s.nextDir;
+            head[i] = B::Next(s.snake.front(), s.dir);
+        }
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            r[i] = !B::Inside(head[i]) || OnSnakes(v, head[i]) || head[i] == head[1-i] ? TICK_DIED : TICK_MOVED;
+            died |= r[i] == TICK_DIED;
+        }
+        if (died) return;
+        bool eaten = false;
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+            GameState& s = v.p[i];
+            s.snake.insert(s.snake.begin(), head[i]);
+            if (head[i] == v.p[0].food) {
+                s.score += 10;
+                r[i] = TICK_ATE;
+                eaten = true;
+            }
+            else s.snake.pop_back();
+        }
+        if (eaten) PlaceFood<B>(v);
+    }
+    template<class B> static bool Full(const VersusGame& v) {
+        return (int)(v.p[0].snake.size() + v.p[1].snake.size()) + 2 >= B::cells;
+    }
+};
+
+// Scratch for ReachableArea, sized once per game so the fill never allocates.
+// A cell counts as seen when its mark equals the current stamp, so nothing
+// has to be cleared between fills.
+struct FloodFill {
+    std::vector<unsigned> mark;
+    std::vector<int> queue;
+    unsigned stamp = 0;
+};
+
+template<class B = ScreenBoard> void FloodFillReset(FloodFill& f) {
+    f.mark.assign(B::cells, 0);
+    f.queue.resize(B::cells);
+    f.stamp = 0;
+}
+
+// Free cells reachable from `from` once the snake moved there (its tail has
+// left). Stops counting as soon as more than `limit` cells were found, so
+// a roomy board costs about as much as a tight one.
+template<class B = ScreenBoard> int ReachableArea(FloodFill& f, const GameState& s, const Point& from, int limit) {
+    if (!B::Inside(from) || OnWall<B>(s, from)) return 0;
+    if (++f.stamp == 0) { // wrapped around, old marks could look current
+        std::fill(f.mark.begin(), f.mark.end(), 0);
+        f.stamp = 1;
+    }
+    for (size_t i = 0; i + 1 < s.snake.size(); ++i) f.mark[B::Index(s.snake[i])] = f.stamp;
+    int start = B::Index(from);
+    if (f.mark[start] == f.stamp) return 0;
+    f.mark[start] = f.stamp;
+    int head = 0, tail = 0;
+    f.queue[tail++] = start;
+    while (head < tail && tail <= limit) {
+        int c = f.queue[head++], x = c % B::cols;
+        int next[4] = {c - B::cols, c + B::cols, x > 0 ? c - 1 : -1, x < B::cols - 1 ? c + 1 : -1};
+        for (int n : next) {
+            if (n < 0 || n >= B::cells || f.mark[n] == f.stamp) continue;
+            f.mark[n] = f.stamp;
+            if (s.walls && LevelBit(s.walls, n)) continue;
+            f.queue[tail++] = n;
+        }
+    }
+    return tail;
+}
@@ -0,0 +1,120 @@
+#include <SDL.h>
+#include <cstring>
+#include "Level_pack.h"
+#include "Game_rules.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+const int LEVEL_HEADER_SIZE = 16;
+const int LEVEL_BLOCK_HEADER = 32; // name[24], cols, rows, wall count
+const int MAX_LEVELS = 256;
+
+static const unsigned char* gData = nullptr;
+static size_t gSize = 0;
+static int gCount = 0;
+static Level gLevels[MAX_LEVELS];
+static signed char gState[MAX_LEVELS]; // 0 not looked at yet, 1 ok, -1 bad
+#ifdef _WIN32
+static HANDLE gFile = INVALID_HANDLE_VALUE, gMapping = nullptr;
+#endif
+
+static Uint16 Read16(const unsigned char* p) { return (Uint16)(p[0] | p[1] << 8); }
+static Uint32 Read32(const unsigned char* p) { return p[0] | p[1] << 8 | p[2] << 16 | (Uint32)p[3] << 24; }
+
+static bool MapFile(const char* path) {
+#ifdef _WIN32
+    gFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (gFile == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(gFile, &size) || size.QuadPart == 0) return false;
+    gMapping = CreateFileMappingA(gFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (gMapping == nullptr) return false;
+    gData = static_cast<const unsigned char*>(MapViewOfFile(gMapping, FILE_MAP_READ, 0, 0, 0));
+    gSize = (size_t)size.QuadPart;
+    return gData != nullptr;
+#else
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) return false;
+    struct stat st;
+    if (fstat(fd, &st) != 0 || st.st_size == 0) { close(fd); return false; }
+    void* p = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (p == MAP_FAILED) return false;
+    gData = static_cast<const unsigned char*>(p);
+    gSize = st.st_size;
+    return true;
+#endif
+}
+
+bool LevelPackOpen(const char* path) {
+    LevelPackClose();
+    if (!MapFile(path)) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Cannot map level pack %s", path);
+        LevelPackClose();
+        return false;
+    }
+    if (gSize < LEVEL_HEADER_SIZE || memcmp(gData, "SNKL", 4) != 0 || Read16(gData + 4) != 1) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "%s is not a level pack", path);
+        LevelPackClose();
+        return false;
+    }
+    Uint32 dir = Read32(gData + 8);
+    gCount = SDL_min((int)Read16(gData + 6), MAX_LEVELS);
+    if (dir + (size_t)gCount * 8 > gSize) gCount = 0;
+    memset(gState, 0, sizeof(gState));
+    return true;
+}
+
+void LevelPackClose() {
+#ifdef _WIN32
+    if (gData) UnmapViewOfFile(gData);
+    if (gMapping) CloseHandle(gMapping);
+    if (gFile != INVALID_HANDLE_VALUE) CloseHandle(gFile);
+    gMapping = nullptr;
+    gFile = INVALID_HANDLE_VALUE;
+#else
+    if (gData) munmap((void*)gData, gSize);
+#endif
+    gData = nullptr;
+    gSize = 0;
+    gCount = 0;
+}
+
+int LevelCount() {
+    return gCount;
+}
+
+bool LevelGet(int i, Level& out) {
+    if (i < 0 || i >= gCount) return false;
+    if (gState[i] == 0) {
+        gState[i] = -1;
+        const unsigned char* entry = gData + Read32(gData + 8) + i * 8;
+        Uint32 offset = Read32(entry), size = Read32(entry + 4);
+        if (offset + (size_t)size > gSize || size < (Uint32)LEVEL_BLOCK_HEADER) return false;
+        const unsigned char* block = gData + offset;
+        Level& l = gLevels[i];
+        l.name = reinterpret_cast<const char*>(block);
+        l.cols = Read16(block + 24);
+        l.rows = Read16(block + 26);
+        l.wallCount = (int)Read32(block + 28);
+        l.bits = block + LEVEL_BLOCK_HEADER;
+        Point start(SCREEN_WIDTH/2/RECT_SIZE*RECT_SIZE, SCREEN_HEIGHT/2/RECT_SIZE*RECT_SIZE);
+        if (memchr(l.name, 0, 24) == nullptr ||
+            l.cols != SCREEN_WIDTH/RECT_SIZE || l.rows != SCREEN_HEIGHT/RECT_SIZE ||
+            size < LEVEL_BLOCK_HEADER + (Uint32)(l.cols * l.rows + 7) / 8 ||
+            LevelBit(l.bits, CellIndex(start))) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN, "Level %d does not fit this board", i);
+            return false;
+        }
+        gState[i] = 1;
+    }
+    if (gState[i] < 0) return false;
+    out = gLevels[i];
+    return true;
+}
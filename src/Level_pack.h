@@ -0,0 +1,21 @@
+#pragma once
+
+// Obstacle levels from assets/levels.pak (format in assets/make_levels.py).
+// The pack is memory-mapped once; a level is only looked at the first time
+// it is asked for, and its wall bits are used in place as the collision mask.
+struct Level {
+    const char* name;
+    int cols, rows;
+    int wallCount;
+    const unsigned char* bits; // one bit per cell, row-major, LSB first
+};
+
+bool LevelPackOpen(const char* path);
+void LevelPackClose();
+int LevelCount();
+// Fills `out` for level i; false if the entry is damaged or does not fit the board.
+bool LevelGet(int i, Level& out);
+
+inline bool LevelBit(const unsigned char* bits, int cell) {
+    return (bits[cell >> 3] >> (cell & 7)) & 1;
+}
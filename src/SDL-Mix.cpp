@@ -2,11 +2,15 @@
 #include <SDL.h>
 #include <SDL_mixer.h>
 #include "SDL-Mix.h"
+#include "Telemetry.h"
+#include "Asset_loader.h"
 #include <vector>
 #include <string>
  Mix_Music *loadMusic(const char* path)
     {
+        Uint64 start = SDL_GetPerformanceCounter();
         Mix_Music *gMusic = Mix_LoadMUS(path);
+        TelemetryPush(TEL_ASSET, TelemetryUsSince(start), 0, path);
         if (gMusic == nullptr) {
             SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
                            "Could not load music! SDL_mixer Error: %s", Mix_GetError());
@@ -26,11 +30,15 @@
     }
 
     Mix_Chunk* loadSound(const char* path) {
+        if (Mix_Chunk* loaded = AssetTakeSound(path)) return loaded; // decoded at startup
+        Uint64 start = SDL_GetPerformanceCounter();
         Mix_Chunk* gChunk = Mix_LoadWAV(path);
+        TelemetryPush(TEL_ASSET, TelemetryUsSince(start), 0, path);
         if (gChunk == nullptr) {
             SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
                        "Could not load sound! SDL_mixer Error: %s", Mix_GetError());
         }
+        return gChunk;
     }
     void play(Mix_Chunk* gChunk) {
         if (gChunk != nullptr) {
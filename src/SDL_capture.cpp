@@ -0,0 +1,162 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include "SDL_capture.h"
+using namespace std;
+
+static bool gActive = false;
+static bool gY4M = false;
+static string gTarget;
+static FILE* gY4MFile = nullptr;
+static int gW = 0, gH = 0;
+
+// single producer (game thread), single consumer (encoder thread)
+static Uint32* gRing[CAPTURE_RING_SIZE];
+static SDL_atomic_t gHead, gTail;
+static SDL_sem* gReady = nullptr;
+static SDL_atomic_t gStopping;
+static SDL_Thread* gEncoder = nullptr;
+static Uint32 gCaptured = 0, gDropped = 0, gWritten = 0;
+static int gEvery = 1; // capture stride, in presented frames
+static Uint32 gPresented = 0;
+static Uint64 gReadbackTicks = 0, gReadbackPeak = 0; // performance counter
+static Uint8* gYUV = nullptr; // encoder thread only
+
+static void WritePNG(const Uint32* pixels, Uint32 index) {
+    SDL_Surface* surf = SDL_CreateRGBSurfaceWithFormatFrom((void*)pixels, gW, gH, 32, gW * 4, SDL_PIXELFORMAT_ARGB8888);
+    if (surf == nullptr) return;
+    char name[512];
+    snprintf(name, sizeof(name), "%s%06u.png", gTarget.c_str(), index);
+    if (IMG_SavePNG(surf, name) != 0) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Capture %s failed: %s", name, IMG_GetError());
+    }
+    SDL_FreeSurface(surf);
+}
+
+// BT.601 full range, 4:2:0 (C420jpeg)
+static void WriteY4M(const Uint32* pixels) {
+    Uint8* yp = gYUV;
+    Uint8* up = gYUV + gW * gH;
+    Uint8* vp = up + (gW / 2) * (gH / 2);
+    for (int y = 0; y < gH; ++y) {
+        const Uint32* row = pixels + y * gW;
+        for (int x = 0; x < gW; ++x) {
+            int r = (row[x] >> 16) & 255, g = (row[x] >> 8) & 255, b = row[x] & 255;
+            yp[y * gW + x] = (Uint8)((77 * r + 150 * g + 29 * b + 128) >> 8);
+        }
+    }
+    for (int y = 0; y < gH / 2; ++y) {
+        for (int x = 0; x < gW / 2; ++x) {
+            int r = 0, g = 0, b = 0;
+            for (int k = 0; k < 4; ++k) {
+                Uint32 p = pixels[(2 * y + k / 2) * gW + 2 * x + k % 2];
+                r += (p >> 16) & 255; g += (p >> 8) & 255; b += p & 255;
+            }
+            r /= 4; g /= 4; b /= 4;
+            up[y * (gW / 2) + x] = (Uint8)SDL_max(0, SDL_min(255, ((-43 * r - 85 * g + 128 * b + 128) >> 8) + 128));
+            vp[y * (gW / 2) + x] = (Uint8)SDL_max(0, SDL_min(255, ((128 * r - 107 * g - 21 * b + 128) >> 8) + 128));
+        }
+    }
+    fputs("FRAME\n", gY4MFile);
+    fwrite(gYUV, 1, gW * gH + 2 * (gW / 2) * (gH / 2), gY4MFile);
+}
+
+static int EncoderThread(void*) {
+    while (true) {
+        SDL_SemWait(gReady);
+        int tail = SDL_AtomicGet(&gTail);
+        if (tail == SDL_AtomicGet(&gHead)) {
+            if (SDL_AtomicGet(&gStopping)) break;
+            continue;
+        }
+        SDL_MemoryBarrierAcquire();
+        const Uint32* frame = gRing[tail % CAPTURE_RING_SIZE];
+        if (gY4M) WriteY4M(frame);
+        else WritePNG(frame, gWritten + 1);
+        ++gWritten;
+        SDL_MemoryBarrierRelease();
+        SDL_AtomicSet(&gTail, tail + 1);
+    }
+    return 0;
+}
+
+bool CaptureStart(SDL_Renderer* ren, const char* target, int every) {
+    if (gActive) return true;
+    gEvery = SDL_max(every, 1);
+    if (SDL_GetRendererOutputSize(ren, &gW, &gH) != 0) return false;
+    gTarget = target;
+    gY4M = gTarget.size() > 4 && gTarget.compare(gTarget.size() - 4, 4, ".y4m") == 0;
+    if (gY4M) {
+        gW &= ~1; gH &= ~1; // 4:2:0 wants even sizes
+        gY4MFile = fopen(target, "wb");
+        if (gY4MFile == nullptr) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Cannot open %s", target);
+            return false;
+        }
+        // frames are only presented when something changes, the rate is nominal
+        fprintf(gY4MFile, "YUV4MPEG2 W%d H%d F60:1 Ip A1:1 C420jpeg\n", gW, gH);
+        gYUV = new Uint8[gW * gH + 2 * (gW / 2) * (gH / 2)];
+    }
+    for (int i = 0; i < CAPTURE_RING_SIZE; ++i) gRing[i] = new Uint32[gW * gH];
+    SDL_AtomicSet(&gHead, 0);
+    SDL_AtomicSet(&gTail, 0);
+    SDL_AtomicSet(&gStopping, 0);
+    gCaptured = gDropped = gWritten = gPresented = 0;
+    gReadbackTicks = gReadbackPeak = 0;
+    gReady = SDL_CreateSemaphore(0);
+    gEncoder = SDL_CreateThread(EncoderThread, "capture", nullptr);
+    gActive = true;
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "Recording %dx%d to %s, one frame in %d", gW, gH, target, gEvery);
+    return true;
+}
+
+bool CaptureActive() {
+    return gActive;
+}
+
+void CaptureFrame(SDL_Renderer* ren) {
+    if (!gActive || gPresented++ % gEvery != 0) return;
+    ++gCaptured;
+    // room is checked first, a dropped frame is never read back
+    int head = SDL_AtomicGet(&gHead);
+    if (head - SDL_AtomicGet(&gTail) >= CAPTURE_RING_SIZE) {
+        ++gDropped; // encoder is behind, never wait for it
+        return;
+    }
+    SDL_MemoryBarrierAcquire();
+    SDL_Rect area{0, 0, gW, gH};
+    // the stall the game does pay: the renderer finishes the frame and copies it back
+    Uint64 start = SDL_GetPerformanceCounter();
+    int failed = SDL_RenderReadPixels(ren, &area, SDL_PIXELFORMAT_ARGB8888, gRing[head % CAPTURE_RING_SIZE], gW * 4);
+    Uint64 took = SDL_GetPerformanceCounter() - start;
+    gReadbackTicks += took;
+    gReadbackPeak = SDL_max(gReadbackPeak, took);
+    if (failed != 0) {
+        ++gDropped;
+        return;
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&gHead, head + 1);
+    SDL_SemPost(gReady);
+}
+
+void CaptureStop() {
+    if (!gActive) return;
+    SDL_AtomicSet(&gStopping, 1);
+    SDL_SemPost(gReady);
+    SDL_WaitThread(gEncoder, nullptr);
+    SDL_DestroySemaphore(gReady);
+    for (int i = 0; i < CAPTURE_RING_SIZE; ++i) delete[] gRing[i];
+    if (gY4MFile) fclose(gY4MFile);
+    delete[] gYUV;
+    gY4MFile = nullptr;
+    gYUV = nullptr;
+    gActive = false;
+    Uint32 readBack = gCaptured - gDropped;
+    double us = 1000000.0 / SDL_GetPerformanceFrequency();
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                   "Recording done: %u frames presented, %u captured, %u written, %u dropped, readback %.0f us mean, %.0f us peak",
+                   gPresented, gCaptured, gWritten, gDropped, readBack ? gReadbackTicks * us / readBack : 0.0, gReadbackPeak * us);
+}
@@ -0,0 +1,21 @@
+#pragma once
+#include <SDL.h>
+
+// Session recording. Presented frames are copied into a preallocated ring
+// and written by a background thread, either as a PNG sequence
+// (<prefix>000001.png ...) or as one uncompressed .y4m file. The game never
+// waits for the encoder: when it falls behind, frames are dropped and
+// counted before anything is read back.
+// The copy itself is not free: every captured frame is one synchronous
+// SDL_RenderReadPixels of the whole window on the game thread, which on a
+// GPU renderer waits for the frame to finish drawing and moves
+// w * h * 4 bytes back (1.9 MB at 600x800). `every` > 1 captures only every
+// n-th presented frame to spread that cost; CaptureStop logs the mean and
+// peak readback time.
+const int CAPTURE_RING_SIZE = 8;
+
+bool CaptureStart(SDL_Renderer* ren, const char* target, int every = 1);
+void CaptureStop();
+bool CaptureActive();
+// Call right before SDL_RenderPresent. Skipped and dropped frames cost no readback.
+void CaptureFrame(SDL_Renderer* ren);
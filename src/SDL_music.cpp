@@ -0,0 +1,315 @@
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <cstring>
+#include <string>
+#include "SDL_music.h"
+#include "Telemetry.h"
+using namespace std;
+
+enum { TRACK_PENDING, TRACK_READY, TRACK_FAILED };
+
+struct MusicTrack {
+    string path;
+    SDL_atomic_t state;
+    Mix_Chunk* chunk;   // decoded PCM, written by the worker before TRACK_READY
+    Mix_Music* music;   // fallback path only
+    int frames;
+};
+
+// What the worker is rendering: the current track and the one fading out.
+struct MusicCursor {
+    int track = -1;
+    int pos = 0;
+};
+
+static MusicTrack gTracks[MAX_MUSIC_TRACKS];
+static int gTrackCount = 0;
+static bool gStarted = false;  // streaming, false means the Mix_Music fallback
+static int gFallbackTrack = -1;
+static int gFreq = 44100;
+
+// ring of interleaved stereo samples, written by the worker, read by the hook
+static Sint16* gRing = nullptr;
+static Uint32 gRingSize = 0; // samples, power of two
+static Uint32 gAhead = 0;    // samples the worker keeps filled
+static SDL_atomic_t gWritePos, gReadPos;
+static SDL_atomic_t gUnderruns, gUnderrunFrames;
+static SDL_atomic_t gLive; // the worker is filling, running dry now is an underrun
+
+// game thread -> worker
+static SDL_mutex* gLock = nullptr;
+static int gWantTrack = -1, gWantFade = 0, gWantSeq = 0;
+static SDL_sem* gWake = nullptr;
+static SDL_sem* gDecodeWake = nullptr;
+static SDL_atomic_t gRunning;
+static SDL_Thread* gWorker = nullptr;
+static SDL_Thread* gDecoder = nullptr; // decoding takes long, it gets its own thread
+
+// worker only
+static MusicCursor gCur, gOld;
+static int gFadeFrames = 0, gFadeDone = 0, gSeenSeq = 0;
+static Sint16 gBlock[MUSIC_BLOCK * 2];
+static Uint64 gDecodeCounter = 0, gRenderCounter = 0;
+static int gDecoded = 0;
+
+static const Sint16* TrackData(int t) {
+    if (t < 0 || SDL_AtomicGet(&gTracks[t].state) != TRACK_READY) return nullptr;
+    return reinterpret_cast<const Sint16*>(gTracks[t].chunk->abuf);
+}
+
+// Adds `frames` of the track under `c` times a gain ramp, looping at the end.
+// False when the track is not decoded (yet).
+static bool RenderTrack(float* acc, MusicCursor& c, int frames, float g0, float step) {
+    const Sint16* data = TrackData(c.track);
+    if (data == nullptr || gTracks[c.track].frames == 0) return false;
+    int len = gTracks[c.track].frames;
+    for (int i = 0; i < frames; ++i) {
+        float g = g0 + step * i;
+        acc[2*i] += data[2*c.pos] * g;
+        acc[2*i + 1] += data[2*c.pos + 1] * g;
+        if (++c.pos == len) c.pos = 0; // seamless loop, the PCM is contiguous
+    }
+    return true;
+}
+
+static void RenderBlock() {
+    static float acc[MUSIC_BLOCK * 2];
+    if (!TrackData(gCur.track) && !TrackData(gOld.track)) {
+        // still decoding: silence, and the fade-in waits for the music
+        memset(gBlock, 0, sizeof(gBlock));
+        return;
+    }
+    memset(acc, 0, sizeof(acc));
+    if (gFadeDone < gFadeFrames) {
+        float t0 = (float)gFadeDone / gFadeFrames, step = 1.0f / gFadeFrames;
+        int n = SDL_min(MUSIC_BLOCK, gFadeFrames - gFadeDone);
+        RenderTrack(acc, gCur, n, t0, step);
+        RenderTrack(acc, gOld, n, 1 - t0, -step);
+        gFadeDone += n;
+        if (n < MUSIC_BLOCK) RenderTrack(acc + 2*n, gCur, MUSIC_BLOCK - n, 1, 0);
+        if (gFadeDone == gFadeFrames) gOld.track = -1;
+    }
+    else RenderTrack(acc, gCur, MUSIC_BLOCK, 1, 0);
+    for (int i = 0; i < MUSIC_BLOCK * 2; ++i) gBlock[i] = (Sint16)SDL_max(-32768.0f, SDL_min(32767.0f, acc[i]));
+}
+
+static void TakeRequest() {
+    SDL_LockMutex(gLock);
+    int track = gWantTrack, fade = gWantFade, seq = gWantSeq;
+    SDL_UnlockMutex(gLock);
+    if (seq == gSeenSeq) return;
+    gSeenSeq = seq;
+    if (track == gCur.track) return;
+    gOld = gCur;
+    gCur.track = track;
+    gCur.pos = 0;
+    gFadeFrames = SDL_max(1, (int)((Sint64)fade * gFreq / 1000));
+    gFadeDone = 0;
+}
+
+static int MusicDecoder(void*) {
+    while (SDL_AtomicGet(&gRunning)) {
+        SDL_SemWait(gDecodeWake);
+        SDL_LockMutex(gLock);
+        int count = gTrackCount;
+        SDL_UnlockMutex(gLock);
+        for (int t = 0; t < count; ++t) {
+            MusicTrack& tr = gTracks[t];
+            if (SDL_AtomicGet(&tr.state) != TRACK_PENDING) continue;
+            Uint64 start = SDL_GetPerformanceCounter();
+            tr.chunk = Mix_LoadWAV(tr.path.c_str());
+            gDecodeCounter += SDL_GetPerformanceCounter() - start;
+            TelemetryPush(TEL_ASSET, TelemetryUsSince(start), 0, tr.path.c_str());
+            if (tr.chunk == nullptr) {
+                SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+                               "Could not decode music %s: %s", tr.path.c_str(), Mix_GetError());
+                SDL_AtomicSet(&tr.state, TRACK_FAILED);
+                continue;
+            }
+            tr.frames = (int)(tr.chunk->alen / 4);
+            ++gDecoded;
+            SDL_MemoryBarrierRelease();
+            SDL_AtomicSet(&tr.state, TRACK_READY);
+        }
+    }
+    return 0;
+}
+
+static void MusicHook(void*, Uint8* stream, int len);
+
+// SDL_mixer decodes on the audio thread, for tracks Mix_LoadWAV cannot take
+// or when streaming is off. Called with gLock held while streaming.
+static void PlayFallback(int track) {
+    if (track == gFallbackTrack && Mix_PlayingMusic()) return;
+    MusicTrack& tr = gTracks[track];
+    if (tr.music == nullptr) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        tr.music = Mix_LoadMUS(tr.path.c_str());
+        TelemetryPush(TEL_ASSET, TelemetryUsSince(start), 0, tr.path.c_str());
+        if (tr.music == nullptr) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+                           "Could not load music %s: %s", tr.path.c_str(), Mix_GetError());
+            return;
+        }
+    }
+    if (gStarted) Mix_HookMusic(nullptr, nullptr);
+    Mix_PlayMusic(tr.music, -1);
+    gFallbackTrack = track;
+}
+
+static int MusicWorker(void*) {
+    while (SDL_AtomicGet(&gRunning)) {
+        TakeRequest();
+        if (gCur.track >= 0 && SDL_AtomicGet(&gTracks[gCur.track].state) == TRACK_FAILED) {
+            SDL_LockMutex(gLock);
+            if (gWantSeq == gSeenSeq && gFallbackTrack != gCur.track) PlayFallback(gCur.track);
+            SDL_UnlockMutex(gLock);
+        }
+        Uint32 write = (Uint32)SDL_AtomicGet(&gWritePos);
+        while (write - (Uint32)SDL_AtomicGet(&gReadPos) + MUSIC_BLOCK * 2 <= gAhead) {
+            Uint64 start = SDL_GetPerformanceCounter();
+            RenderBlock();
+            for (int i = 0; i < MUSIC_BLOCK * 2; ++i) gRing[(write + i) & (gRingSize - 1)] = gBlock[i];
+            gRenderCounter += SDL_GetPerformanceCounter() - start;
+            write += MUSIC_BLOCK * 2;
+            SDL_MemoryBarrierRelease();
+            SDL_AtomicSet(&gWritePos, (int)write);
+            SDL_AtomicSet(&gLive, 1);
+        }
+        // the hook wakes us after each read, the timeout covers a stopped device
+        SDL_SemWaitTimeout(gWake, 20);
+    }
+    return 0;
+}
+
+// Mix_HookMusic callback, on the audio thread: copy only.
+static void MusicHook(void*, Uint8* stream, int len) {
+    Sint16* out = reinterpret_cast<Sint16*>(stream);
+    Uint32 samples = len / 2;
+    Uint32 read = (Uint32)SDL_AtomicGet(&gReadPos);
+    Uint32 avail = (Uint32)SDL_AtomicGet(&gWritePos) - read;
+    SDL_MemoryBarrierAcquire();
+    Uint32 n = SDL_min(samples, avail);
+    Uint32 first = SDL_min(n, gRingSize - (read & (gRingSize - 1)));
+    memcpy(out, gRing + (read & (gRingSize - 1)), first * 2);
+    memcpy(out + first, gRing, (n - first) * 2);
+    if (n < samples) {
+        memset(out + n, 0, (samples - n) * 2);
+        if (SDL_AtomicGet(&gLive)) {
+            SDL_AtomicAdd(&gUnderruns, 1);
+            SDL_AtomicAdd(&gUnderrunFrames, (int)(samples - n) / 2);
+        }
+    }
+    SDL_AtomicSet(&gReadPos, (int)(read + n));
+    SDL_SemPost(gWake);
+}
+
+static void StopThreads() {
+    SDL_AtomicSet(&gRunning, 0);
+    SDL_SemPost(gWake);
+    SDL_SemPost(gDecodeWake);
+    if (gWorker) SDL_WaitThread(gWorker, nullptr);
+    if (gDecoder) SDL_WaitThread(gDecoder, nullptr);
+    gWorker = gDecoder = nullptr;
+    SDL_DestroySemaphore(gWake);
+    SDL_DestroySemaphore(gDecodeWake);
+    gWake = gDecodeWake = nullptr;
+    delete[] gRing;
+    gRing = nullptr;
+}
+
+bool MusicInit() {
+    int freq, channels;
+    Uint16 format;
+    gLock = SDL_CreateMutex();
+    if (!Mix_QuerySpec(&freq, &format, &channels) || format != AUDIO_S16SYS || channels != 2) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                       "Music streaming needs 16-bit stereo output, using Mix_PlayMusic");
+        return false;
+    }
+    gFreq = freq;
+    gAhead = (Uint32)(MUSIC_AHEAD_MS * freq / 1000 * 2);
+    gRingSize = 1;
+    while (gRingSize < gAhead + MUSIC_BLOCK * 2) gRingSize <<= 1;
+    gRing = new Sint16[gRingSize]();
+    SDL_AtomicSet(&gWritePos, 0);
+    SDL_AtomicSet(&gReadPos, 0);
+    SDL_AtomicSet(&gLive, 0);
+    gWake = SDL_CreateSemaphore(0);
+    gDecodeWake = SDL_CreateSemaphore(0);
+    SDL_AtomicSet(&gRunning, 1);
+    gWorker = SDL_CreateThread(MusicWorker, "music", nullptr);
+    gDecoder = SDL_CreateThread(MusicDecoder, "music decode", nullptr);
+    if (gWorker == nullptr || gDecoder == nullptr) {
+        StopThreads();
+        return false;
+    }
+    Mix_HookMusic(MusicHook, nullptr);
+    gStarted = true;
+    SDL_SemPost(gDecodeWake); // tracks queued before the init
+    return true;
+}
+
+void MusicQuit() {
+    if (gStarted) {
+        Mix_HookMusic(nullptr, nullptr); // waits for a running callback
+        if (gFallbackTrack >= 0) Mix_HaltMusic();
+        StopThreads();
+        double f = (double)SDL_GetPerformanceFrequency();
+        Uint32 blocks = (Uint32)SDL_AtomicGet(&gWritePos) / (MUSIC_BLOCK * 2);
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                       "music: %d tracks decoded in %.0f ms, %.1f us per %d-frame block, %d underruns (%d frames)",
+                       gDecoded, gDecodeCounter / f * 1e3, blocks ? gRenderCounter / f * 1e6 / blocks : 0.0,
+                       MUSIC_BLOCK, SDL_AtomicGet(&gUnderruns), SDL_AtomicGet(&gUnderrunFrames));
+        gStarted = false;
+    }
+    else if (gFallbackTrack >= 0) Mix_HaltMusic();
+    for (int t = 0; t < gTrackCount; ++t) {
+        if (gTracks[t].chunk) Mix_FreeChunk(gTracks[t].chunk);
+        if (gTracks[t].music) Mix_FreeMusic(gTracks[t].music);
+        gTracks[t].chunk = nullptr;
+        gTracks[t].music = nullptr;
+    }
+    gTrackCount = 0;
+    gFallbackTrack = -1;
+    if (gLock) SDL_DestroyMutex(gLock);
+    gLock = nullptr;
+}
+
+int MusicLoad(const char* path) {
+    for (int t = 0; t < gTrackCount; ++t) {
+        if (gTracks[t].path == path) return t;
+    }
+    if (gTrackCount == MAX_MUSIC_TRACKS) return -1;
+    MusicTrack& tr = gTracks[gTrackCount];
+    tr.path = path;
+    tr.chunk = nullptr;
+    tr.music = nullptr;
+    tr.frames = 0;
+    SDL_AtomicSet(&tr.state, TRACK_PENDING);
+    if (gLock) SDL_LockMutex(gLock);
+    int t = gTrackCount++;
+    if (gLock) SDL_UnlockMutex(gLock);
+    if (gStarted) SDL_SemPost(gDecodeWake);
+    return t;
+}
+
+void MusicPlay(int track, int fadeMs) {
+    if (track < 0 || track >= gTrackCount) return;
+    if (!gStarted) {
+        PlayFallback(track);
+        return;
+    }
+    SDL_LockMutex(gLock);
+    if (gFallbackTrack >= 0 && SDL_AtomicGet(&gTracks[track].state) != TRACK_FAILED) {
+        // back from a track that could not be decoded ahead
+        Mix_HaltMusic();
+        Mix_HookMusic(MusicHook, nullptr);
+        gFallbackTrack = -1;
+    }
+    gWantTrack = track;
+    gWantFade = fadeMs;
+    ++gWantSeq;
+    SDL_UnlockMutex(gLock);
+    SDL_SemPost(gWake);
+}
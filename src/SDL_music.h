@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL.h>
+
+// Music streaming. Tracks are decoded to PCM on a worker thread, which also
+// renders loops and cross-fades ahead of time into a ring buffer; the
+// SDL_mixer music hook only copies from the ring. A slow frame or a slow
+// decode can therefore never stall the audio callback, at worst the ring
+// runs dry (an underrun, counted and logged).
+const int MUSIC_AHEAD_MS  = 200; // audio kept decoded ahead of the callback
+const int MUSIC_BLOCK     = 1024; // frames the worker renders at a time
+const int MAX_MUSIC_TRACKS = 8;
+
+// Needs the mixer opened as 16-bit stereo; without it the calls below fall
+// back to Mix_LoadMUS / Mix_PlayMusic.
+bool MusicInit();
+// Logs decode time, worker load and underruns.
+void MusicQuit();
+// Queues a file for decoding and returns its track id (the same id for the
+// same path), -1 when no slot is left.
+int MusicLoad(const char* path);
+// Loops `track`, cross-fading from the one playing. Plays once the decode
+// is done; a track that is already playing keeps going.
+void MusicPlay(int track, int fadeMs = 0);
@@ -0,0 +1,100 @@
+#include <SDL.h>
+#include <cmath>
+#include "SDL_particles.h"
+
+static const float PARTICLE_SIZE = 3.0f;
+
+// Structure of arrays: the update loop only walks the float arrays it needs.
+static float pX[MAX_PARTICLES], pY[MAX_PARTICLES];
+static float pVX[MAX_PARTICLES], pVY[MAX_PARTICLES];
+static float pGravity[MAX_PARTICLES];
+static float pLife[MAX_PARTICLES], pInvMaxLife[MAX_PARTICLES];
+static SDL_Color pColor[MAX_PARTICLES];
+static int pCount = 0;
+
+// One quad (4 vertices, 6 indices) per particle, drawn with a single call.
+static SDL_Vertex gVerts[MAX_PARTICLES*4];
+static int gIndices[MAX_PARTICLES*6];
+static bool gIndicesReady = false;
+
+// Own generator so effects never disturb the rand() sequence of the game.
+static Uint32 gSeed = 2463534242u;
+static float RandUnit() {
+    gSeed ^= gSeed << 13; gSeed ^= gSeed >> 17; gSeed ^= gSeed << 5;
+    return (gSeed >> 8) * (1.0f / 16777216.0f);
+}
+
+void ParticlesClear() {
+    pCount = 0;
+}
+
+void ParticlesBurst(float x, float y, int count, float speed, float life, SDL_Color color, float gravity) {
+    if (count > MAX_PARTICLES - pCount) count = MAX_PARTICLES - pCount;
+    for (int k = 0; k < count; ++k) {
+        int i = pCount++;
+        float a = RandUnit() * 6.2831853f;
+        float v = speed * (0.25f + 0.75f * RandUnit());
+        float l = life * (0.5f + 0.5f * RandUnit());
+        pX[i] = x; pY[i] = y;
+        pVX[i] = cosf(a) * v; pVY[i] = sinf(a) * v;
+        pGravity[i] = gravity;
+        pLife[i] = l; pInvMaxLife[i] = 1.0f / l;
+        pColor[i] = color;
+    }
+}
+
+void ParticlesUpdate(float dt) {
+    const int n = pCount;
+    float* __restrict x = pX; float* __restrict y = pY;
+    float* __restrict vx = pVX; float* __restrict vy = pVY;
+    const float* __restrict g = pGravity;
+    float* __restrict life = pLife;
+    // branch free so the compiler can vectorize these
+    for (int i = 0; i < n; ++i) vy[i] += g[i] * dt;
+    for (int i = 0; i < n; ++i) { x[i] += vx[i] * dt; y[i] += vy[i] * dt; }
+    for (int i = 0; i < n; ++i) life[i] -= dt;
+
+    // compact the dead ones out, order does not matter
+    int alive = 0;
+    for (int i = 0; i < n; ++i) {
+        if (life[i] <= 0) continue;
+        if (alive != i) {
+            pX[alive] = pX[i]; pY[alive] = pY[i];
+            pVX[alive] = pVX[i]; pVY[alive] = pVY[i];
+            pGravity[alive] = pGravity[i];
+            pLife[alive] = pLife[i]; pInvMaxLife[alive] = pInvMaxLife[i];
+            pColor[alive] = pColor[i];
+        }
+        ++alive;
+    }
+    pCount = alive;
+}
+
+void ParticlesRender(SDL_Renderer* ren) {
+    if (pCount == 0) return;
+    if (!gIndicesReady) {
+        for (int i = 0; i < MAX_PARTICLES; ++i) {
+            int* q = gIndices + i*6;
+            q[0] = i*4; q[1] = i*4+1; q[2] = i*4+2;
+            q[3] = i*4+2; q[4] = i*4+3; q[5] = i*4;
+        }
+        gIndicesReady = true;
+    }
+    for (int i = 0; i < pCount; ++i) {
+        SDL_Color c = pColor[i];
+        c.a = (Uint8)(c.a * SDL_min(1.0f, pLife[i] * pInvMaxLife[i]));
+        SDL_Vertex* v = gVerts + i*4;
+        float x0 = pX[i], y0 = pY[i], x1 = x0 + PARTICLE_SIZE, y1 = y0 + PARTICLE_SIZE;
+        v[0].position = {x0, y0}; v[1].position = {x1, y0};
+        v[2].position = {x1, y1}; v[3].position = {x0, y1};
+        v[0].color = v[1].color = v[2].color = v[3].color = c;
+        v[0].tex_coord = v[1].tex_coord = v[2].tex_coord = v[3].tex_coord = {0, 0};
+    }
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    SDL_RenderGeometry(ren, nullptr, gVerts, pCount*4, gIndices, pCount*6);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
+int ParticlesAlive() {
+    return pCount;
+}
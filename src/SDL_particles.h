@@ -0,0 +1,12 @@
+#pragma once
+#include <SDL.h>
+
+// Fixed-capacity particle pool kept as separate arrays (x, y, vx, vy, life...),
+// nothing is allocated after the first ParticlesRender call.
+const int MAX_PARTICLES = 65536;
+
+void ParticlesClear();
+void ParticlesBurst(float x, float y, int count, float speed, float life, SDL_Color color, float gravity = 0);
+void ParticlesUpdate(float dt);
+void ParticlesRender(SDL_Renderer* ren);
+int ParticlesAlive();
@@ -0,0 +1,295 @@
+#include <SDL.h>
+#include <SDL_image.h>
+#include <cstring>
+#include <iostream>
+#include "SDL_softraster.h"
+#include "Game_rules.h"
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#define SOFT_X86 1
+#endif
+using namespace std;
+
+struct SoftSprite {
+    SDL_Texture* tex;
+    Uint32* pixels; // premultiplied ARGB8888
+    int w, h;
+    bool opaque;
+};
+
+const int MAX_SOFT_SPRITES = 16;
+static SoftSprite gSprites[MAX_SOFT_SPRITES];
+static int gSpriteCount = 0;
+static Uint32* gFrame = nullptr;
+static int gFrameW = 0, gFrameH = 0;
+static SDL_Texture* gFrameTexture = nullptr;
+static Uint32* gStatic = nullptr; // static layers, see SoftRasterSave
+
+// dst = src + dst * (255 - src.a) / 255, src is premultiplied
+static void BlendRowScalar(Uint32* dst, const Uint32* src, int n) {
+    for (int i = 0; i < n; ++i) {
+        Uint32 s = src[i], d = dst[i];
+        Uint32 inv = 255 - (s >> 24);
+        Uint32 rb = (d & 0x00ff00ff) * inv + 0x00800080;
+        Uint32 ag = ((d >> 8) & 0x00ff00ff) * inv + 0x00800080;
+        rb = ((rb + ((rb >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+        ag = (ag + ((ag >> 8) & 0x00ff00ff)) & 0xff00ff00;
+        dst[i] = s + (rb | ag);
+    }
+}
+
+#ifdef SOFT_X86
+// exact x/255 for 16-bit lanes holding up to 255*255
+#define DIV255_SSE(t) _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(t, k128), _mm_srli_epi16(_mm_add_epi16(t, k128), 8)), 8)
+#define DIV255_AVX(t) _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(t, k128), _mm256_srli_epi16(_mm256_add_epi16(t, k128), 8)), 8)
+
+__attribute__((target("sse2")))
+static void BlendRowSSE2(Uint32* dst, const Uint32* src, int n) {
+    const __m128i zero = _mm_setzero_si128(), k255 = _mm_set1_epi16(255), k128 = _mm_set1_epi16(128);
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        __m128i d = _mm_loadu_si128((const __m128i*)(dst + i));
+        __m128i sa = _mm_unpacklo_epi8(s, zero), sb = _mm_unpackhi_epi8(s, zero);
+        __m128i ia = _mm_sub_epi16(k255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(sa, 0xff), 0xff));
+        __m128i ib = _mm_sub_epi16(k255, _mm_shufflehi_epi16(_mm_shufflelo_epi16(sb, 0xff), 0xff));
+        __m128i da = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), ia);
+        __m128i db = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), ib);
+        da = _mm_add_epi16(DIV255_SSE(da), sa);
+        db = _mm_add_epi16(DIV255_SSE(db), sb);
+        _mm_storeu_si128((__m128i*)(dst + i), _mm_packus_epi16(da, db));
+    }
+    BlendRowScalar(dst + i, src + i, n - i);
+}
+
+__attribute__((target("avx2")))
+static void BlendRowAVX2(Uint32* dst, const Uint32* src, int n) {
+    const __m256i zero = _mm256_setzero_si256(), k255 = _mm256_set1_epi16(255), k128 = _mm256_set1_epi16(128);
+    // alpha of each pixel copied to its four 16-bit lanes
+    const __m256i alpha = _mm256_setr_epi8(6,7,6,7,6,7,6,7, 14,15,14,15,14,15,14,15,
+                                           6,7,6,7,6,7,6,7, 14,15,14,15,14,15,14,15);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m256i s = _mm256_loadu_si256((const __m256i*)(src + i));
+        __m256i d = _mm256_loadu_si256((const __m256i*)(dst + i));
+        __m256i sa = _mm256_unpacklo_epi8(s, zero), sb = _mm256_unpackhi_epi8(s, zero);
+        __m256i ia = _mm256_sub_epi16(k255, _mm256_shuffle_epi8(sa, alpha));
+        __m256i ib = _mm256_sub_epi16(k255, _mm256_shuffle_epi8(sb, alpha));
+        __m256i da = _mm256_mullo_epi16(_mm256_unpacklo_epi8(d, zero), ia);
+        __m256i db = _mm256_mullo_epi16(_mm256_unpackhi_epi8(d, zero), ib);
+        da = _mm256_add_epi16(DIV255_AVX(da), sa);
+        db = _mm256_add_epi16(DIV255_AVX(db), sb);
+        _mm256_storeu_si256((__m256i*)(dst + i), _mm256_packus_epi16(da, db));
+    }
+    BlendRowSSE2(dst + i, src + i, n - i);
+}
+#endif
+
+typedef void (*BlendRowFn)(Uint32*, const Uint32*, int);
+static BlendRowFn gBlendRow = BlendRowScalar;
+static const char* gKernel = "scalar";
+
+static void PickKernel() {
+#ifdef SOFT_X86
+    if (SDL_HasAVX2()) { gBlendRow = BlendRowAVX2; gKernel = "AVX2"; return; }
+    if (SDL_HasSSE2()) { gBlendRow = BlendRowSSE2; gKernel = "SSE2"; return; }
+#endif
+    gBlendRow = BlendRowScalar;
+    gKernel = "scalar";
+}
+
+const char* SoftRasterKernel() {
+    return gKernel;
+}
+
+bool SoftRasterInit(SDL_Renderer* ren, int w, int h) {
+    PickKernel();
+    gFrameTexture = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_STREAMING, w, h);
+    if (gFrameTexture == nullptr) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Soft raster texture failed: %s", SDL_GetError());
+        return false;
+    }
+    gFrame = static_cast<Uint32*>(SDL_SIMDAlloc(sizeof(Uint32) * w * h));
+    gFrameW = w; gFrameH = h;
+    memset(gFrame, 0, sizeof(Uint32) * w * h);
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "Soft raster %dx%d, %s kernel", w, h, gKernel);
+    return true;
+}
+
+void SoftRasterQuit() {
+    while (gSpriteCount > 0) SoftRasterRemove(gSprites[0].tex);
+    if (gFrameTexture) SDL_DestroyTexture(gFrameTexture);
+    SDL_SIMDFree(gFrame);
+    SDL_SIMDFree(gStatic);
+    gFrameTexture = nullptr;
+    gFrame = nullptr;
+    gStatic = nullptr;
+}
+
+bool SoftRasterAdd(SDL_Texture* tex, const char* file, int w, int h) {
+    if (gSpriteCount == MAX_SOFT_SPRITES) return false;
+    SDL_Surface* loaded = IMG_Load(file);
+    if (loaded == nullptr) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Soft raster load %s failed: %s", file, IMG_GetError());
+        return false;
+    }
+    SDL_Surface* scaled = SDL_CreateRGBSurfaceWithFormat(0, w, h, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_SetSurfaceBlendMode(loaded, SDL_BLENDMODE_NONE);
+    SDL_BlitScaled(loaded, nullptr, scaled, nullptr);
+    SDL_FreeSurface(loaded);
+
+    SoftSprite& sp = gSprites[gSpriteCount++];
+    sp.tex = tex; sp.w = w; sp.h = h; sp.opaque = true;
+    sp.pixels = static_cast<Uint32*>(SDL_SIMDAlloc(sizeof(Uint32) * w * h));
+    for (int y = 0; y < h; ++y) {
+        const Uint32* row = reinterpret_cast<const Uint32*>(static_cast<Uint8*>(scaled->pixels) + y * scaled->pitch);
+        for (int x = 0; x < w; ++x) {
+            Uint32 p = row[x], a = p >> 24;
+            if (a != 255) sp.opaque = false;
+            Uint32 r = ((p >> 16) & 255) * a / 255, g = ((p >> 8) & 255) * a / 255, b = (p & 255) * a / 255;
+            sp.pixels[y * w + x] = (a << 24) | (r << 16) | (g << 8) | b;
+        }
+    }
+    SDL_FreeSurface(scaled);
+    return true;
+}
+
+void SoftRasterRemove(SDL_Texture* tex) {
+    for (int i = 0; i < gSpriteCount; ++i) {
+        if (gSprites[i].tex != tex) continue;
+        SDL_SIMDFree(gSprites[i].pixels);
+        gSprites[i] = gSprites[--gSpriteCount];
+        return;
+    }
+}
+
+void SoftRasterDraw(SDL_Texture* tex, int x, int y) {
+    const SoftSprite* sp = nullptr;
+    for (int i = 0; i < gSpriteCount; ++i) if (gSprites[i].tex == tex) { sp = &gSprites[i]; break; }
+    if (sp == nullptr || gFrame == nullptr) return;
+    int x0 = SDL_max(x, 0), y0 = SDL_max(y, 0);
+    int x1 = SDL_min(x + sp->w, gFrameW), y1 = SDL_min(y + sp->h, gFrameH);
+    if (x0 >= x1 || y0 >= y1) return;
+    for (int row = y0; row < y1; ++row) {
+        Uint32* dst = gFrame + row * gFrameW + x0;
+        const Uint32* src = sp->pixels + (row - y) * sp->w + (x0 - x);
+        // opaque layers (the background) are a plain row copy, libc already vectorizes it
+        if (sp->opaque) memcpy(dst, src, sizeof(Uint32) * (x1 - x0));
+        else gBlendRow(dst, src, x1 - x0);
+    }
+}
+
+void SoftRasterFill(const SDL_Rect* rects, int n, SDL_Color color) {
+    if (gFrame == nullptr) return;
+    Uint32 px = (Uint32)color.a << 24 | color.r << 16 | color.g << 8 | color.b;
+    for (int i = 0; i < n; ++i) {
+        int x0 = SDL_max(rects[i].x, 0), y0 = SDL_max(rects[i].y, 0);
+        int x1 = SDL_min(rects[i].x + rects[i].w, gFrameW), y1 = SDL_min(rects[i].y + rects[i].h, gFrameH);
+        for (int y = y0; y < y1; ++y) {
+            Uint32* dst = gFrame + y * gFrameW;
+            for (int x = x0; x < x1; ++x) dst[x] = px;
+        }
+    }
+}
+
+void SoftRasterSave() {
+    if (gFrame == nullptr) return;
+    if (gStatic == nullptr) gStatic = static_cast<Uint32*>(SDL_SIMDAlloc(sizeof(Uint32) * gFrameW * gFrameH));
+    if (gStatic) memcpy(gStatic, gFrame, sizeof(Uint32) * gFrameW * gFrameH);
+}
+
+bool SoftRasterRestore(const SDL_Rect* rect) {
+    if (gStatic == nullptr || gFrame == nullptr) return false;
+    if (rect == nullptr) {
+        memcpy(gFrame, gStatic, sizeof(Uint32) * gFrameW * gFrameH);
+        return true;
+    }
+    int x0 = SDL_max(rect->x, 0), y0 = SDL_max(rect->y, 0);
+    int x1 = SDL_min(rect->x + rect->w, gFrameW), y1 = SDL_min(rect->y + rect->h, gFrameH);
+    for (int y = y0; y < y1; ++y)
+        memcpy(gFrame + y * gFrameW + x0, gStatic + y * gFrameW + x0, sizeof(Uint32) * (x1 - x0));
+    return true;
+}
+
+void SoftRasterFlush(SDL_Renderer* ren, const SDL_Rect* rects, int n) {
+    if (gFrameTexture == nullptr) return;
+    // the streaming texture keeps its content, so only changed rects need uploading
+    if (rects == nullptr) SDL_UpdateTexture(gFrameTexture, nullptr, gFrame, gFrameW * sizeof(Uint32));
+    for (int i = 0; rects && i < n; ++i)
+        SDL_UpdateTexture(gFrameTexture, &rects[i], gFrame + rects[i].y * gFrameW + rects[i].x, gFrameW * sizeof(Uint32));
+    SDL_RenderCopy(ren, gFrameTexture, nullptr, nullptr);
+}
+
+// Same layout as a mid-game board: background, food and a 300 cell snake.
+static void BenchBoard(Point* cells, int count) {
+    const int cols = SCREEN_WIDTH/RECT_SIZE;
+    for (int i = 0; i < count; ++i) {
+        int row = i / cols, col = (row % 2 == 0) ? i % cols : cols - 1 - i % cols;
+        cells[i] = Point(col * RECT_SIZE, (5 + row) * RECT_SIZE);
+    }
+}
+
+int RunRasterBenchmark(int frames) {
+    if (frames <= 0) frames = 500;
+    if (SDL_Init(SDL_INIT_VIDEO) != 0 || !(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG)) {
+        cerr << "SDL_Init Error: " << SDL_GetError() << endl;
+        return 1;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* ren = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    SDL_Texture* bg = ren ? IMG_LoadTexture(ren, "background.jpg") : nullptr;
+    SDL_Texture* head = ren ? IMG_LoadTexture(ren, "head.png") : nullptr;
+    SDL_Texture* body = ren ? IMG_LoadTexture(ren, "body.png") : nullptr;
+    SDL_Texture* food = ren ? IMG_LoadTexture(ren, "food.png") : nullptr;
+    if (!bg || !head || !body || !food) {
+        cerr << "Benchmark setup failed: " << SDL_GetError() << endl;
+        return 1;
+    }
+    const int snakeLen = 300;
+    Point cells[snakeLen];
+    BenchBoard(cells, snakeLen);
+    Point apple(SCREEN_WIDTH/2, 2 * RECT_SIZE);
+
+    Uint64 freq = SDL_GetPerformanceFrequency();
+    Uint64 t0 = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; ++f) {
+        SDL_RenderClear(ren);
+        SDL_RenderCopy(ren, bg, nullptr, nullptr);
+        SDL_Rect rf{apple.x, apple.y, RECT_SIZE, RECT_SIZE};
+        SDL_RenderCopy(ren, food, nullptr, &rf);
+        for (int i = 0; i < snakeLen; ++i) {
+            SDL_Rect rs{cells[i].x, cells[i].y, RECT_SIZE, RECT_SIZE};
+            SDL_RenderCopy(ren, i == 0 ? head : body, nullptr, &rs);
+        }
+        SDL_RenderPresent(ren);
+    }
+    double sdlMs = (SDL_GetPerformanceCounter() - t0) * 1000.0 / freq / frames;
+
+    if (!SoftRasterInit(ren, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !SoftRasterAdd(bg, "background.jpg", SCREEN_WIDTH, SCREEN_HEIGHT) ||
+        !SoftRasterAdd(head, "head.png", RECT_SIZE, RECT_SIZE) ||
+        !SoftRasterAdd(body, "body.png", RECT_SIZE, RECT_SIZE) ||
+        !SoftRasterAdd(food, "food.png", RECT_SIZE, RECT_SIZE)) {
+        cerr << "Soft raster setup failed" << endl;
+        return 1;
+    }
+    t0 = SDL_GetPerformanceCounter();
+    for (int f = 0; f < frames; ++f) {
+        SoftRasterDraw(bg, 0, 0);
+        SoftRasterDraw(food, apple.x, apple.y);
+        for (int i = 0; i < snakeLen; ++i) SoftRasterDraw(i == 0 ? head : body, cells[i].x, cells[i].y);
+        SoftRasterFlush(ren);
+        SDL_RenderPresent(ren);
+    }
+    double softMs = (SDL_GetPerformanceCounter() - t0) * 1000.0 / freq / frames;
+
+    cout << "SDL software renderer: " << sdlMs << " ms/frame" << endl;
+    cout << "Framebuffer (" << SoftRasterKernel() << "): " << softMs << " ms/frame" << endl;
+
+    SoftRasterQuit();
+    SDL_DestroyTexture(bg); SDL_DestroyTexture(head); SDL_DestroyTexture(body); SDL_DestroyTexture(food);
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    IMG_Quit(); SDL_Quit();
+    return 0;
+}
@@ -0,0 +1,26 @@
+#pragma once
+#include <SDL.h>
+
+// Built-in framebuffer renderer for machines without a GPU. Sprites are
+// scaled once when they are added, frames are composed with SSE2/AVX2
+// kernels into one buffer that is uploaded as a single streaming texture,
+// so SDL's software renderer never has to scale anything per frame.
+bool SoftRasterInit(SDL_Renderer* ren, int w, int h);
+void SoftRasterQuit();
+// Loads `file` scaled to w x h and draws it whenever `tex` is drawn.
+bool SoftRasterAdd(SDL_Texture* tex, const char* file, int w, int h);
+void SoftRasterRemove(SDL_Texture* tex);
+void SoftRasterDraw(SDL_Texture* tex, int x, int y);
+void SoftRasterFill(const SDL_Rect* rects, int n, SDL_Color color);
+// Keeps a copy of the frame drawn so far (the static layers), restoring it
+// starts the next frame with one copy, or repaints one rect of it.
+// Restore fails when nothing was saved.
+void SoftRasterSave();
+bool SoftRasterRestore(const SDL_Rect* rect = nullptr);
+// Uploads the framebuffer (only `rects` when given) and copies it to the renderer.
+void SoftRasterFlush(SDL_Renderer* ren, const SDL_Rect* rects = nullptr, int n = 0);
+const char* SoftRasterKernel();
+
+// Draws the same board with SDL's software renderer and with the
+// framebuffer path, prints the time per frame of each.
+int RunRasterBenchmark(int frames);
@@ -2,10 +2,17 @@
 #include <SDL_image.h>
 #include <iostream>
 #include "SDL_utils.h"
+#include "Telemetry.h"
+#include "Asset_loader.h"
 #include <vector>
 #include <string>
 #include <SDL_ttf.h>
 #include <SDL_mixer.h>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/resource.h>
+#endif
 void logErrorAndExit(const char* msg, const char* error)
 {
     SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "%s: %s", msg, error);
@@ -62,7 +69,16 @@ SDL_Texture *loadTexture(const char *filename, SDL_Renderer* renderer)
 {
 	SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "Loading %s", filename);
 
+	// decoded at startup (Asset_loader.h), only the upload is left
+	if (SDL_Surface* decoded = AssetSurface(filename)) {
+		SDL_Texture *texture = SDL_CreateTextureFromSurface(renderer, decoded);
+		if (texture == NULL)
+			SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Upload texture %s failed: %s", filename, SDL_GetError());
+		return texture;
+	}
+	Uint64 start = SDL_GetPerformanceCounter();
 	SDL_Texture *texture = IMG_LoadTexture(renderer, filename);
+	TelemetryPush(TEL_ASSET, TelemetryUsSince(start), 0, filename);
 	if (texture == NULL)
         SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Load texture %s failed: %s", filename, IMG_GetError()); // <<< SỬA LỖI >>> Thêm filename vào log lỗi
 
@@ -79,3 +95,26 @@ void renderTexture(SDL_Texture *texture, int x, int y,
 	SDL_RenderCopy(renderer, texture, NULL, &dest);
 }
 
+double processCpuSeconds()
+{
+#ifdef _WIN32
+    FILETIME created, exited, kernel, user;
+    if (!GetProcessTimes(GetCurrentProcess(), &created, &exited, &kernel, &user)) return 0;
+    ULARGE_INTEGER k, u;
+    k.LowPart = kernel.dwLowDateTime; k.HighPart = kernel.dwHighDateTime;
+    u.LowPart = user.dwLowDateTime; u.HighPart = user.dwHighDateTime;
+    return (k.QuadPart + u.QuadPart) / 1e7;
+#else
+    rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return 0;
+    return ru.ru_utime.tv_sec + ru.ru_stime.tv_sec + (ru.ru_utime.tv_usec + ru.ru_stime.tv_usec) / 1e6;
+#endif
+}
+void logCpuUsage(const char* scene, double cpuStart, Uint32 ticksStart)
+{
+    Uint32 wall = SDL_GetTicks() - ticksStart;
+    if (wall == 0) return;
+    double cpu = processCpuSeconds() - cpuStart;
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "%s: %.1f%% CPU over %.1f s",
+                   scene, 100.0 * cpu / (wall / 1000.0), wall / 1000.0);
+}
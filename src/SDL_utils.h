@@ -9,3 +9,6 @@ void quitSDL(SDL_Window* window, SDL_Renderer* renderer);
 SDL_Texture *loadTexture(const char *filename, SDL_Renderer* renderer);
 void renderTexture(SDL_Texture *texture, int x, int y,
                    SDL_Renderer* renderer);
+// CPU time used by the whole process, for the idle usage reports
+double processCpuSeconds();
+void logCpuUsage(const char* scene, double cpuStart, Uint32 ticksStart);
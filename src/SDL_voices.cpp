@@ -0,0 +1,293 @@
+#include <SDL.h>
+#include <SDL_mixer.h>
+#include <cmath>
+#include <cstring>
+#include <vector>
+#include <iostream>
+#include "SDL_voices.h"
+#if defined(__GNUC__) && (defined(__i386__) || defined(__x86_64__))
+#include <immintrin.h>
+#define VOICES_X86 1
+#endif
+using namespace std;
+
+struct Voice {
+    const Sint16* data; // interleaved stereo, already in the device format
+    int frames, pos;
+    float gainL, gainR;
+    int priority;
+};
+
+struct VoiceRequest {
+    const Sint16* data;
+    int frames;
+    float gainL, gainR;
+    int priority;
+};
+
+// Voices are mixed in blocks through a float accumulator of this many
+// samples, so the callback never allocates whatever the device buffer size.
+const int MIX_BLOCK = 1024;
+
+// single producer (game thread), single consumer (audio thread)
+static VoiceRequest gQueue[VOICE_QUEUE_SIZE];
+static SDL_atomic_t gQueueHead, gQueueTail;
+static Voice gVoices[MAX_VOICES]; // 0..gActive-1 are playing, audio thread only
+static int gActive = 0;
+static float gAcc[MIX_BLOCK];
+static bool gStarted = false;
+static int gFreq = 44100;
+
+// audio thread counters, read once the callback is unhooked
+static Uint64 gCallbacks = 0, gMixCounter = 0, gPeakCounter = 0;
+static int gPeakVoices = 0;
+static SDL_atomic_t gStolen, gDropped;
+
+// acc += src * gain, interleaved L/R
+static void MixVoiceScalar(float* acc, const Sint16* src, int n, float gl, float gr) {
+    for (int i = 0; i + 1 < n; i += 2) {
+        acc[i] += src[i] * gl;
+        acc[i + 1] += src[i + 1] * gr;
+    }
+}
+
+// out = saturate(out + acc)
+static void ResolveScalar(Sint16* out, const float* acc, int n) {
+    for (int i = 0; i < n; ++i) {
+        float v = SDL_max(-32768.0f, SDL_min(32767.0f, out[i] + acc[i]));
+        out[i] = (Sint16)lrintf(v);
+    }
+}
+
+#ifdef VOICES_X86
+__attribute__((target("sse2")))
+static void MixVoiceSSE2(float* acc, const Sint16* src, int n, float gl, float gr) {
+    const __m128 g = _mm_setr_ps(gl, gr, gl, gr);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i s = _mm_loadu_si128((const __m128i*)(src + i));
+        // sign-extend the 16-bit samples to 32 bits
+        __m128 lo = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(s, s), 16));
+        __m128 hi = _mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(s, s), 16));
+        _mm_storeu_ps(acc + i, _mm_add_ps(_mm_loadu_ps(acc + i), _mm_mul_ps(lo, g)));
+        _mm_storeu_ps(acc + i + 4, _mm_add_ps(_mm_loadu_ps(acc + i + 4), _mm_mul_ps(hi, g)));
+    }
+    MixVoiceScalar(acc + i, src + i, n - i, gl, gr);
+}
+
+__attribute__((target("sse2")))
+static void ResolveSSE2(Sint16* out, const float* acc, int n) {
+    const __m128 lowest = _mm_set1_ps(-32768.0f), highest = _mm_set1_ps(32767.0f);
+    int i = 0;
+    for (; i + 8 <= n; i += 8) {
+        __m128i o = _mm_loadu_si128((const __m128i*)(out + i));
+        __m128 lo = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpacklo_epi16(o, o), 16)), _mm_loadu_ps(acc + i));
+        __m128 hi = _mm_add_ps(_mm_cvtepi32_ps(_mm_srai_epi32(_mm_unpackhi_epi16(o, o), 16)), _mm_loadu_ps(acc + i + 4));
+        // clamp first, cvtps turns out-of-range values into INT_MIN
+        lo = _mm_max_ps(lowest, _mm_min_ps(highest, lo));
+        hi = _mm_max_ps(lowest, _mm_min_ps(highest, hi));
+        _mm_storeu_si128((__m128i*)(out + i), _mm_packs_epi32(_mm_cvtps_epi32(lo), _mm_cvtps_epi32(hi)));
+    }
+    ResolveScalar(out + i, acc + i, n - i);
+}
+#endif
+
+typedef void (*MixVoiceFn)(float*, const Sint16*, int, float, float);
+typedef void (*ResolveFn)(Sint16*, const float*, int);
+static MixVoiceFn gMixVoice = MixVoiceScalar;
+static ResolveFn gResolve = ResolveScalar;
+static const char* gKernel = "scalar";
+
+static void PickKernel(bool simd) {
+#ifdef VOICES_X86
+    if (simd && SDL_HasSSE2()) {
+        gMixVoice = MixVoiceSSE2;
+        gResolve = ResolveSSE2;
+        gKernel = "SSE2";
+        return;
+    }
+#endif
+    gMixVoice = MixVoiceScalar;
+    gResolve = ResolveScalar;
+    gKernel = "scalar";
+}
+
+// The slot a new voice goes to, -1 to drop it.
+static int VoiceSlot(int priority) {
+    if (gActive < MAX_VOICES) return gActive++;
+    int victim = 0;
+    for (int i = 1; i < MAX_VOICES; ++i) {
+        const Voice& v = gVoices[i];
+        const Voice& w = gVoices[victim];
+        if (v.priority < w.priority || (v.priority == w.priority && v.pos > w.pos)) victim = i;
+    }
+    if (gVoices[victim].priority > priority) {
+        SDL_AtomicAdd(&gDropped, 1);
+        return -1;
+    }
+    SDL_AtomicAdd(&gStolen, 1);
+    return victim;
+}
+
+static void StartQueued() {
+    int tail = SDL_AtomicGet(&gQueueTail), head = SDL_AtomicGet(&gQueueHead);
+    SDL_MemoryBarrierAcquire();
+    for (; tail != head; ++tail) {
+        const VoiceRequest& r = gQueue[tail & (VOICE_QUEUE_SIZE - 1)];
+        int slot = VoiceSlot(r.priority);
+        if (slot < 0) continue;
+        gVoices[slot] = Voice{r.data, r.frames, 0, r.gainL, r.gainR, r.priority};
+    }
+    SDL_AtomicSet(&gQueueTail, tail);
+}
+
+// Adds every playing voice to `out` (samples interleaved L/R).
+static void MixInto(Sint16* out, int samples) {
+    StartQueued();
+    gPeakVoices = SDL_max(gPeakVoices, gActive);
+    for (int done = 0; done < samples && gActive > 0; done += MIX_BLOCK) {
+        int n = SDL_min(MIX_BLOCK, samples - done);
+        memset(gAcc, 0, n * sizeof(float));
+        for (int i = 0; i < gActive; ++i) {
+            Voice& v = gVoices[i];
+            int frames = SDL_min(n / 2, v.frames - v.pos);
+            gMixVoice(gAcc, v.data + v.pos * 2, frames * 2, v.gainL, v.gainR);
+            v.pos += frames;
+        }
+        gResolve(out + done, gAcc, n);
+        // finished voices leave, the last one takes their slot
+        for (int i = 0; i < gActive; ) {
+            if (gVoices[i].pos >= gVoices[i].frames) gVoices[i] = gVoices[--gActive];
+            else ++i;
+        }
+    }
+}
+
+static void PostMix(void*, Uint8* stream, int len) {
+    Uint64 start = SDL_GetPerformanceCounter();
+    MixInto(reinterpret_cast<Sint16*>(stream), len / 2);
+    Uint64 spent = SDL_GetPerformanceCounter() - start;
+    ++gCallbacks;
+    gMixCounter += spent;
+    gPeakCounter = SDL_max(gPeakCounter, spent);
+}
+
+bool VoicesInit() {
+    int freq, channels;
+    Uint16 format;
+    if (!Mix_QuerySpec(&freq, &format, &channels) || format != AUDIO_S16SYS || channels != 2) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_WARN,
+                       "Voice mixer needs 16-bit stereo output, using mixer channels");
+        return false;
+    }
+    PickKernel(true);
+    gFreq = freq;
+    gActive = 0;
+    SDL_AtomicSet(&gQueueHead, 0);
+    SDL_AtomicSet(&gQueueTail, 0);
+    Mix_SetPostMix(PostMix, nullptr);
+    gStarted = true;
+    return true;
+}
+
+void VoicesQuit() {
+    if (!gStarted) return;
+    Mix_SetPostMix(nullptr, nullptr); // waits for a running callback
+    gStarted = false;
+    gActive = 0;
+    if (gCallbacks == 0) return;
+    double f = (double)SDL_GetPerformanceFrequency();
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                   "voices (%s): %llu callbacks, %.1f us per callback, peak %.1f us, peak %d voices, %d stolen, %d dropped",
+                   gKernel, (unsigned long long)gCallbacks, gMixCounter / f * 1e6 / gCallbacks, gPeakCounter / f * 1e6,
+                   gPeakVoices, SDL_AtomicGet(&gStolen), SDL_AtomicGet(&gDropped));
+}
+
+static bool Queue(Mix_Chunk* chunk, float gain, float pan, int priority) {
+    int head = SDL_AtomicGet(&gQueueHead);
+    if (head - SDL_AtomicGet(&gQueueTail) >= VOICE_QUEUE_SIZE) {
+        SDL_AtomicAdd(&gDropped, 1);
+        return false;
+    }
+    float g = gain * chunk->volume / MIX_MAX_VOLUME;
+    pan = SDL_max(-1.0f, SDL_min(1.0f, pan));
+    VoiceRequest& r = gQueue[head & (VOICE_QUEUE_SIZE - 1)];
+    r.data = reinterpret_cast<const Sint16*>(chunk->abuf);
+    r.frames = (int)(chunk->alen / 4);
+    r.gainL = g * SDL_min(1.0f, 1 - pan);
+    r.gainR = g * SDL_min(1.0f, 1 + pan);
+    r.priority = priority;
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&gQueueHead, head + 1);
+    return true;
+}
+
+void VoicePlay(Mix_Chunk* chunk, float gain, float pan, int priority) {
+    if (chunk == nullptr) return;
+    if (!gStarted) {
+        Mix_PlayChannel(-1, chunk, 0);
+        return;
+    }
+    Queue(chunk, gain, pan, priority);
+}
+
+int RunMixerBenchmark(int callbacks) {
+    if (callbacks <= 0) callbacks = 2000;
+    const int frames = 2048; // the buffer size InitSDL opens the device with
+    const int voices = MAX_VOICES + 64; // some get stolen
+    // one second of noise per voice, a different gain and pan each
+    vector<vector<Sint16> > data(voices, vector<Sint16>(gFreq * 2));
+    vector<Mix_Chunk> chunks(voices);
+    Uint32 seed = 1;
+    for (int v = 0; v < voices; ++v) {
+        for (Sint16& x : data[v]) {
+            seed = seed * 1664525u + 1013904223u;
+            x = (Sint16)(seed >> 16) / 4;
+        }
+        chunks[v].allocated = 0;
+        chunks[v].abuf = reinterpret_cast<Uint8*>(data[v].data());
+        chunks[v].alen = (Uint32)(data[v].size() * 2);
+        chunks[v].volume = MIX_MAX_VOLUME;
+    }
+    vector<Sint16> out(frames * 2), check(frames * 2);
+    SDL_AtomicSet(&gStolen, 0);
+    SDL_AtomicSet(&gDropped, 0);
+
+    // the same callbacks through both kernels must agree
+    int mismatches = 0;
+    for (int pass = 0; pass < 2; ++pass) {
+        PickKernel(pass == 1);
+        gActive = 0;
+        SDL_AtomicSet(&gQueueHead, 0);
+        SDL_AtomicSet(&gQueueTail, 0);
+        for (int v = 0; v < voices / 2; ++v) Queue(&chunks[v], 0.5f, v % 9 / 4.0f - 1, v % 3);
+        vector<Sint16>& buf = pass ? out : check;
+        for (int c = 0; c < 4; ++c) {
+            fill(buf.begin(), buf.end(), (Sint16)(c * 1000));
+            MixInto(buf.data(), (int)buf.size());
+            if (c == 1) for (int v = voices / 2; v < voices; ++v) Queue(&chunks[v], 0.5f, v % 9 / 4.0f - 1, v % 3);
+        }
+    }
+    for (int i = 0; i < frames * 2; ++i) mismatches += out[i] != check[i];
+    cout << "mixer kernel " << gKernel << ": " << mismatches << " samples differ from scalar" << endl;
+
+    for (int pass = 0; pass < 2; ++pass) {
+        PickKernel(pass == 1);
+        gActive = 0;
+        Uint64 spent = 0;
+        for (int c = 0; c < callbacks; ++c) {
+            // keep the voice table full: restart what ended
+            for (int v = 0, need = MAX_VOICES - gActive; v < need; ++v) Queue(&chunks[(c + v) % voices], 0.3f, v % 9 / 4.0f - 1, v % 3);
+            fill(out.begin(), out.end(), (Sint16)0);
+            Uint64 start = SDL_GetPerformanceCounter();
+            MixInto(out.data(), (int)out.size());
+            spent += SDL_GetPerformanceCounter() - start;
+        }
+        double us = spent / (double)SDL_GetPerformanceFrequency() * 1e6 / callbacks;
+        cout << "mixer " << gKernel << ": " << MAX_VOICES << " voices, " << frames << " frames: "
+             << us << " us per callback (" << us / (frames * 1e4 / gFreq) << "% of the "
+             << frames * 1000.0 / gFreq << " ms budget)" << endl;
+    }
+    gActive = 0;
+    return mismatches == 0 ? 0 : 1;
+}
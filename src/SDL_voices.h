@@ -0,0 +1,23 @@
+#pragma once
+#include <SDL.h>
+#include <SDL_mixer.h>
+
+// Sound effect mixer on top of SDL_mixer. Effects are added to the output in
+// the Mix_SetPostMix callback instead of taking a mixer channel each, so
+// hundreds of them can overlap. The game thread only queues requests in a
+// lock-free ring, the voices belong to the audio thread. With every voice
+// busy, the one with the lowest priority (the oldest among equals) is
+// stolen, unless the new sound ranks lower still.
+const int MAX_VOICES       = 256;
+const int VOICE_QUEUE_SIZE = 256; // power of two
+
+// Needs the mixer opened as 16-bit stereo; without it VoicePlay falls back
+// to Mix_PlayChannel.
+bool VoicesInit();
+// Logs the per-callback cost. Call before freeing the chunks.
+void VoicesQuit();
+// gain 0..1 (on top of the chunk volume), pan -1 (left) .. 1 (right)
+void VoicePlay(Mix_Chunk* chunk, float gain = 1, float pan = 0, int priority = 0);
+// Mixes synthetic voices without an audio device, checks the SIMD kernels
+// against the scalar ones and reports the cost per callback.
+int RunMixerBenchmark(int callbacks);
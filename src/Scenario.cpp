@@ -0,0 +1,243 @@
+#include <SDL.h>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#ifdef _WIN32
+#include <windows.h>
+#define PSAPI_VERSION 2 // kernel32, no psapi.lib to link
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+#include "Scenario.h"
+#include "Scene.h"
+#include "Frame_arena.h"
+using namespace std;
+
+enum ScriptOp { SCRIPT_KEY, SCRIPT_WAIT, SCRIPT_WAIT_SCENE, SCRIPT_WAIT_LENGTH };
+struct ScriptCmd {
+    ScriptOp op;
+    int n; // ms, length
+    SDL_Keycode key;
+    char scene[16];
+};
+
+static vector<ScriptCmd> gScript;
+static size_t gPc = 0;
+static bool gScriptLoaded = false;
+static bool gScriptDone = false;
+static Uint32 gWaitUntil = 0; // 0 while no wait is running
+static int gSnakeLength = 0;
+
+bool ScriptLoadText(const char* text, const char* name) {
+    gScript.clear();
+    gPc = 0;
+    gScriptDone = false;
+    gWaitUntil = 0;
+    // repeat blocks are unrolled here, the player just walks the list
+    vector<pair<size_t, int>> repeats; // start, count
+    char line[256];
+    int lineNo = 0;
+    bool ok = true;
+    for (const char* p = text; ok && *p; ) {
+        const char* eol = strchr(p, '\n');
+        size_t len = eol ? (size_t)(eol - p) : strlen(p);
+        snprintf(line, sizeof(line), "%.*s", (int)SDL_min(len, sizeof(line) - 1), p);
+        p += len + (eol ? 1 : 0);
+        ++lineNo;
+        if (char* hash = strchr(line, '#')) *hash = 0;
+        char word[32] = "", arg[64] = "";
+        int got = sscanf(line, "%31s %63[^\r\n]", word, arg);
+        if (got <= 0) continue;
+        string w = word;
+        ScriptCmd c{};
+        if (w == "key" && got == 2) {
+            c.op = SCRIPT_KEY;
+            c.key = SDL_GetKeyFromName(arg);
+            ok = c.key != SDLK_UNKNOWN;
+        }
+        else if (w == "wait" && got == 2) { c.op = SCRIPT_WAIT; c.n = atoi(arg); }
+        else if (w == "wait_length" && got == 2) { c.op = SCRIPT_WAIT_LENGTH; c.n = atoi(arg); }
+        else if (w == "wait_scene" && got == 2) {
+            c.op = SCRIPT_WAIT_SCENE;
+            snprintf(c.scene, sizeof(c.scene), "%s", arg);
+        }
+        else if (w == "repeat" && got == 2) { repeats.push_back({gScript.size(), atoi(arg)}); continue; }
+        else if (w == "end" && !repeats.empty()) {
+            size_t start = repeats.back().first, end = gScript.size();
+            for (int i = 1; i < repeats.back().second; ++i)
+                for (size_t j = start; j < end; ++j) gScript.push_back(gScript[j]);
+            repeats.pop_back();
+            continue;
+        }
+        else ok = false;
+        if (ok) gScript.push_back(c);
+    }
+    if (!ok || !repeats.empty()) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR,
+                       "Script: %s line %d: %s", name, lineNo, ok ? "repeat without end" : "bad command");
+        gScript.clear();
+        return false;
+    }
+    gScriptLoaded = true;
+    return true;
+}
+
+bool ScriptLoad(const char* path) {
+    FILE* f = fopen(path, "r");
+    if (!f) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Script: cannot open %s", path);
+        return false;
+    }
+    string text;
+    char buf[4096];
+    for (size_t n; (n = fread(buf, 1, sizeof(buf), f)) > 0; ) text.append(buf, n);
+    fclose(f);
+    return ScriptLoadText(text.c_str(), path);
+}
+
+bool ScriptActive() {
+    return gScriptLoaded;
+}
+
+void ScriptSnakeLength(int length) {
+    gSnakeLength = length;
+}
+
+static void PushKey(Uint32 type, SDL_Keycode key) {
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = type;
+    e.key.state = type == SDL_KEYDOWN ? SDL_PRESSED : SDL_RELEASED;
+    e.key.keysym.sym = key;
+    e.key.keysym.scancode = SDL_GetScancodeFromKey(key);
+    SDL_PushEvent(&e);
+}
+
+void ScriptFrame(const char* scene) {
+    if (!gScriptLoaded || gScriptDone) return;
+    Uint32 now = SDL_GetTicks();
+    while (gPc < gScript.size()) {
+        const ScriptCmd& c = gScript[gPc];
+        switch (c.op) {
+        case SCRIPT_KEY:
+            // one key per frame, as a player would
+            PushKey(SDL_KEYDOWN, c.key);
+            PushKey(SDL_KEYUP, c.key);
+            ++gPc;
+            return;
+        case SCRIPT_WAIT:
+            if (!gWaitUntil) gWaitUntil = now + c.n;
+            if (!SDL_TICKS_PASSED(now, gWaitUntil)) return;
+            gWaitUntil = 0;
+            break;
+        case SCRIPT_WAIT_SCENE:
+            if (strcmp(scene, c.scene) != 0) return;
+            break;
+        case SCRIPT_WAIT_LENGTH:
+            if (gSnakeLength < c.n) return;
+            break;
+        }
+        ++gPc;
+    }
+    SDL_Event e;
+    SDL_zero(e);
+    e.type = SDL_QUIT;
+    SDL_PushEvent(&e);
+    gScriptDone = true;
+}
+
+Sint32 ScriptWaitMs() {
+    if (!gScriptLoaded || gScriptDone || gPc >= gScript.size()) return 0;
+    const ScriptCmd& c = gScript[gPc];
+    if (c.op == SCRIPT_KEY) return 0;
+    if (c.op == SCRIPT_WAIT && gWaitUntil) return SDL_max((Sint32)(gWaitUntil - SDL_GetTicks()), 0);
+    return FRAME_MS; // scene and length changes are polled
+}
+
+// Frame times go into 10 us buckets, so the report costs nothing per frame
+// and the percentiles need no sorting.
+const int PERF_BUCKET_US = 10;
+const int PERF_BUCKETS   = 10000; // up to 100 ms, the last one takes the rest
+
+static unsigned gFrameHist[PERF_BUCKETS];
+static unsigned long long gFrames = 0, gFrameUsTotal = 0;
+static int gFrameUsMax = 0;
+static unsigned long long gTicks = 0, gTickUsTotal = 0;
+static int gTickBatchUsMax = 0;
+static unsigned long long gAllocsAtFirstFrame = 0; // leaves out the startup
+static string gReportPath;
+static Uint32 gReportStart = 0;
+
+void PerfReportStart(const char* path) {
+    gReportPath = path;
+    gReportStart = SDL_GetTicks();
+}
+
+void PerfFrame(int workUs) {
+    if (gReportPath.empty()) return;
+    if (gFrames == 0) gAllocsAtFirstFrame = AllocCount();
+    gFrameHist[SDL_min(SDL_max(workUs, 0) / PERF_BUCKET_US, PERF_BUCKETS - 1)]++;
+    ++gFrames;
+    gFrameUsTotal += workUs;
+    gFrameUsMax = SDL_max(gFrameUsMax, workUs);
+}
+
+void PerfTicks(int ticks, int us) {
+    if (gReportPath.empty()) return;
+    gTicks += ticks;
+    gTickUsTotal += us;
+    gTickBatchUsMax = SDL_max(gTickBatchUsMax, us);
+}
+
+// Upper edge of the bucket holding the p-th percentile.
+static int FramePercentile(double p) {
+    unsigned long long want = (unsigned long long)(gFrames * p), seen = 0;
+    for (int i = 0; i < PERF_BUCKETS; ++i) {
+        seen += gFrameHist[i];
+        if (seen > want) return SDL_min((i + 1) * PERF_BUCKET_US, gFrameUsMax);
+    }
+    return gFrameUsMax;
+}
+
+// Peak resident set size of the process in KB.
+static long PeakRssKb() {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS pmc;
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) return -1;
+    return (long)(pmc.PeakWorkingSetSize / 1024);
+#else
+    struct rusage ru;
+    if (getrusage(RUSAGE_SELF, &ru) != 0) return -1;
+#ifdef __APPLE__
+    return ru.ru_maxrss / 1024; // bytes there
+#else
+    return ru.ru_maxrss;
+#endif
+#endif
+}
+
+void PerfReportWrite() {
+    if (gReportPath.empty()) return;
+    FILE* f = fopen(gReportPath.c_str(), "w");
+    if (!f) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Perf report: cannot write %s", gReportPath.c_str());
+        return;
+    }
+    fprintf(f, "{\"wall_ms\":%u,\"frames\":%llu,\"frame_us_mean\":%.1f,\"frame_us_p50\":%d,"
+               "\"frame_us_p95\":%d,\"frame_us_p99\":%d,\"frame_us_max\":%d,",
+            SDL_GetTicks() - gReportStart, gFrames, gFrames ? (double)gFrameUsTotal / gFrames : 0.0,
+            FramePercentile(0.5), FramePercentile(0.95), FramePercentile(0.99), gFrameUsMax);
+    fprintf(f, "\"ticks\":%llu,\"tick_ns_mean\":%.1f,\"tick_batch_us_max\":%d,",
+            gTicks, gTicks ? gTickUsTotal * 1000.0 / gTicks : 0.0, gTickBatchUsMax);
+    // allocations are only counted in builds with TRACK_ALLOCS
+    if (AllocTrackingEnabled())
+        fprintf(f, "\"allocations\":%llu,\"allocations_per_frame\":%.2f,",
+                AllocCount(), gFrames > 1 ? (double)(AllocCount() - gAllocsAtFirstFrame) / (gFrames - 1) : 0.0);
+    else
+        fprintf(f, "\"allocations\":null,\"allocations_per_frame\":null,");
+    fprintf(f, "\"peak_rss_kb\":%ld}\n", PeakRssKb());
+    fclose(f);
+}
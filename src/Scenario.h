@@ -0,0 +1,33 @@
+#pragma once
+#include <SDL.h>
+
+// Scripted runs for the performance scenarios (assets/run_scenarios.py).
+//
+// --script FILE presses keys from a text file, one command per line:
+//   key NAME         press and release a key (SDL key names: Return, Down, Escape...)
+//   wait MS
+//   wait_scene NAME  until that scene is on top (menu, gameplay, pause, game over)
+//   wait_length N    until the snake is N long
+//   repeat N ... end the lines in between N times
+// '#' starts a comment. The game quits when the script runs out.
+//
+// --perf-report FILE writes frame times, tick times, allocations and peak
+// memory as one JSON object when the game exits.
+bool ScriptLoad(const char* path);
+// The same from memory (built-in scripts), `name` goes into error messages.
+// Loading again starts the new script from its first line.
+bool ScriptLoadText(const char* text, const char* name);
+bool ScriptActive();
+// Once per frame from RunScenes, pushes the key events that are due.
+void ScriptFrame(const char* scene);
+// ms until the script needs the next frame, caps the idle wait.
+Sint32 ScriptWaitMs();
+// From the game after its ticks, for wait_length.
+void ScriptSnakeLength(int length);
+
+void PerfReportStart(const char* path);
+// Work time of a presented frame.
+void PerfFrame(int workUs);
+// One batch of simulation ticks and the time they took.
+void PerfTicks(int ticks, int us);
+void PerfReportWrite();
@@ -0,0 +1,118 @@
+#include <vector>
+#include <memory>
+#include "Scene.h"
+#include "SDL_utils.h"
+#include "SDL_capture.h"
+#include "Frame_arena.h"
+#include "Telemetry.h"
+#include "Scenario.h"
+#include "Asset_loader.h"
+using namespace std;
+
+struct SceneEntry {
+    unique_ptr<Scene> scene;
+    double cpuStart; // for the usage report when the scene goes away
+    Uint32 ticksStart;
+};
+
+enum SceneOpType { SCENE_PUSH, SCENE_POP, SCENE_QUIT };
+struct SceneOp {
+    SceneOpType type;
+    Scene* scene;
+    int count;
+};
+
+static vector<SceneEntry> gStack;
+static vector<SceneOp> gPending;
+
+void ScenePush(Scene* scene) {
+    if (scene) gPending.push_back(SceneOp{SCENE_PUSH, scene, 0});
+}
+
+void ScenePop(int count) {
+    gPending.push_back(SceneOp{SCENE_POP, nullptr, count});
+}
+
+void SceneQuit() {
+    gPending.push_back(SceneOp{SCENE_QUIT, nullptr, 0});
+}
+
+static void PopScene() {
+    SceneEntry& top = gStack.back();
+    logCpuUsage(top.scene->Name(), top.cpuStart, top.ticksStart);
+    gStack.pop_back();
+}
+
+// Returns true when the top scene changed.
+static bool ApplyPending() {
+    if (gPending.empty()) return false;
+    vector<SceneOp> ops;
+    ops.swap(gPending);
+    Scene* before = gStack.empty() ? nullptr : gStack.back().scene.get();
+    bool uncovered = false;
+    for (const SceneOp& op : ops) {
+        if (op.type == SCENE_PUSH) {
+            gStack.push_back(SceneEntry{unique_ptr<Scene>(op.scene), processCpuSeconds(), SDL_GetTicks()});
+            uncovered = false;
+            continue;
+        }
+        int count = op.type == SCENE_QUIT ? (int)gStack.size() : op.count;
+        for (int i = 0; i < count && !gStack.empty(); ++i) PopScene();
+        uncovered = true;
+    }
+    if (gStack.empty()) return true;
+    Scene* top = gStack.back().scene.get();
+    if (top == before) return false;
+    if (uncovered) top->Resume();
+    top->redraw = true;
+    return true;
+}
+
+static void PresentFrame(SDL_Renderer* ren) {
+    if (CaptureActive()) CaptureFrame(ren);
+    SDL_RenderPresent(ren);
+}
+
+void RunScenes(SDL_Renderer* ren, bool vsync) {
+    Uint32 lastPresent = 0;
+    ApplyPending();
+    while (!gStack.empty()) {
+        Scene* top = gStack.back().scene.get();
+        FrameReset();
+        AllocTrackFrame(top->Name());
+        // sleep until the scene needs a frame or input comes, but never
+        // draw more than once per frame slot
+        Sint32 frameWait = vsync ? 0 : (Sint32)(lastPresent + FRAME_MS - SDL_GetTicks());
+        Sint32 wait = top->redraw ? 0 : SDL_max(top->IdleWait(), frameWait);
+        if (ScriptActive()) {
+            ScriptFrame(top->Name());
+            wait = SDL_min(wait, SDL_max(ScriptWaitMs(), frameWait));
+        }
+        SDL_Event e;
+        for (int got = SDL_WaitEventTimeout(&e, SDL_max(wait, 0)); got; got = SDL_PollEvent(&e)) {
+            if (e.type == SDL_QUIT) SceneQuit();
+            else top->HandleEvent(e);
+            if (e.type == SDL_KEYDOWN || e.type == SDL_WINDOWEVENT) top->redraw = true;
+            // the rest of the queue belongs to the next top scene
+            if (!gPending.empty()) break;
+        }
+        if (ApplyPending()) continue;
+
+        Uint64 workStart = SDL_GetPerformanceCounter();
+        top->Update();
+        if (ApplyPending() || !top->redraw) continue;
+        size_t first = gStack.size() - 1;
+        while (first > 0 && gStack[first].scene->Overlay()) --first;
+        for (size_t i = first; i < gStack.size(); ++i) gStack[i].scene->Render(ren);
+        PresentFrame(ren);
+        if (lastPresent == 0) {
+            StartupMark("first frame");
+            StartupLog();
+        }
+        lastPresent = SDL_GetTicks();
+        top->redraw = false;
+        int workUs = TelemetryUsSince(workStart);
+        PerfFrame(workUs);
+        if (workUs > (int)FRAME_MS * 1000) TelemetryPush(TEL_FRAME_SPIKE, workUs);
+    }
+}
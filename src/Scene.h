@@ -0,0 +1,34 @@
+#pragma once
+#include <SDL.h>
+
+const Sint32 MENU_IDLE_WAIT = 1000; // ms a menu sleeps when nobody touches a key
+const Uint32 FRAME_MS       = 16;   // frame pacing when there is no vsync
+
+// One screen of the game (menu, game, pause, game over). They all run on
+// the one main loop in RunScenes through a stack: the top scene gets input
+// and updates, rendering starts at the lowest scene the ones above let show
+// through, so the pause overlay draws over the frozen game.
+class Scene {
+public:
+    virtual ~Scene() {}
+    // also the name used by the allocation and CPU usage reports
+    virtual const char* Name() const = 0;
+    // true when the scene under this one stays visible (and frozen)
+    virtual bool Overlay() const { return false; }
+    virtual void HandleEvent(const SDL_Event& e) = 0;
+    virtual void Update() {}
+    virtual void Render(SDL_Renderer* ren) = 0;
+    // ms the scene may sleep without input, 0 for every frame
+    virtual Sint32 IdleWait() const { return MENU_IDLE_WAIT; }
+    // on top again after the scenes above it were popped
+    virtual void Resume() {}
+    bool redraw = true; // something changed, draw a frame
+};
+
+// Stack changes wait until the current handler or update returns, so a
+// scene can replace or pop itself. Pushed scenes are owned by the stack.
+void ScenePush(Scene* scene);
+void ScenePop(int count = 1);
+void SceneQuit();
+// Runs frames until the stack is empty.
+void RunScenes(SDL_Renderer* ren, bool vsync);
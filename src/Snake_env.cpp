@@ -0,0 +1,182 @@
+#include <vector>
+#include <cstdint>
+#include <cstring>
+#include "Snake_env.h"
+using namespace std;
+
+struct SnakeEnv {
+    int count, cols, rows, cells, words;
+    // one entry per game
+    vector<int32_t> headX, headY, dirX, dirY;
+    vector<int32_t> next;    // cell the head moves to, -1 off the board
+    vector<int32_t> head;    // ring slot of the head
+    vector<int32_t> len, food;
+    vector<uint32_t> rng;
+    // `cells` per game
+    vector<uint16_t> body;   // ring, the tail is len-1 slots behind the head
+    vector<uint64_t> occ;    // `words` per game, bit set where the snake is
+    vector<uint8_t> obs;
+};
+
+static inline uint32_t NextRandom(uint32_t& x) {
+    // xorshift32, one state per game so the games do not depend on each other
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    return x;
+}
+
+static inline bool Occupied(const uint64_t* occ, int c) {
+    return (occ[c >> 6] >> (c & 63)) & 1;
+}
+
+// Random free cell; false when the board is full.
+static bool PlaceFood(SnakeEnv* env, int e) {
+    const uint64_t* occ = &env->occ[(size_t)e * env->words];
+    uint32_t& r = env->rng[e];
+    int c = -1;
+    // rejection sampling is enough until the snake covers most of the board
+    for (int i = 0; i < 32 && c < 0; ++i) {
+        int t = (int)(NextRandom(r) % env->cells);
+        if (!Occupied(occ, t)) c = t;
+    }
+    if (c < 0) {
+        // first free bit after a random word
+        int start = (int)(NextRandom(r) % env->words);
+        for (int i = 0; i < env->words && c < 0; ++i) {
+            int w = (start + i) % env->words;
+            uint64_t freeBits = ~occ[w];
+            if (w == env->words - 1 && env->cells % 64) freeBits &= (1ull << (env->cells % 64)) - 1;
+            if (freeBits) c = w * 64 + __builtin_ctzll(freeBits);
+        }
+        if (c < 0) return false;
+    }
+    env->food[e] = c;
+    env->obs[(size_t)e * env->cells + c] = SNAKE_ENV_FOOD;
+    return true;
+}
+
+// Same start as NewGame: length 1 in the middle, heading right.
+static void ResetGame(SnakeEnv* env, int e) {
+    uint64_t* occ = &env->occ[(size_t)e * env->words];
+    uint8_t* obs = &env->obs[(size_t)e * env->cells];
+    const uint16_t* body = &env->body[(size_t)e * env->cells];
+    // clear only what the last game left, O(length)
+    for (int i = 0; i < env->len[e]; ++i) obs[body[(env->head[e] - i + env->cells) % env->cells]] = SNAKE_ENV_EMPTY;
+    memset(occ, 0, env->words * sizeof(uint64_t));
+    if (env->food[e] >= 0) obs[env->food[e]] = SNAKE_ENV_EMPTY;
+    int x = env->cols / 2, y = env->rows / 2, c = y * env->cols + x;
+    env->headX[e] = x;
+    env->headY[e] = y;
+    env->dirX[e] = 1;
+    env->dirY[e] = 0;
+    env->head[e] = 0;
+    env->len[e] = 1;
+    env->body[(size_t)e * env->cells] = (uint16_t)c;
+    occ[c >> 6] |= 1ull << (c & 63);
+    obs[c] = SNAKE_ENV_HEAD;
+    PlaceFood(env, e);
+}
+
+SnakeEnv* SnakeEnvCreate(int count, int cols, int rows, unsigned seed) {
+    if (count <= 0 || cols < 2 || rows < 1 || cols * rows > 65535) return nullptr;
+    SnakeEnv* env = new SnakeEnv;
+    env->count = count;
+    env->cols = cols;
+    env->rows = rows;
+    env->cells = cols * rows;
+    env->words = (env->cells + 63) / 64;
+    for (vector<int32_t>* v : {&env->headX, &env->headY, &env->dirX, &env->dirY, &env->next, &env->head, &env->len})
+        v->assign(count, 0);
+    env->food.assign(count, -1);
+    env->rng.resize(count);
+    for (int e = 0; e < count; ++e) {
+        uint32_t h = (seed + e) * 2654435761u;
+        env->rng[e] = h ? h : 1;
+    }
+    env->body.assign((size_t)count * env->cells, 0);
+    env->occ.assign((size_t)count * env->words, 0);
+    env->obs.assign((size_t)count * env->cells, SNAKE_ENV_EMPTY);
+    SnakeEnvReset(env);
+    return env;
+}
+
+void SnakeEnvDestroy(SnakeEnv* env) {
+    delete env;
+}
+
+void SnakeEnvReset(SnakeEnv* env) {
+    for (int e = 0; e < env->count; ++e) ResetGame(env, e);
+}
+
+const unsigned char* SnakeEnvObservations(const SnakeEnv* env) {
+    return env->obs.data();
+}
+
+int SnakeEnvLength(const SnakeEnv* env, int i) {
+    return env->len[i];
+}
+
+// Movement for every game, branch-free and without aliasing so the compiler
+// vectorizes it. next gets the cell the head moves to, -1 off the board.
+static void MoveHeads(int n, int cols, int rows, const unsigned char* __restrict act,
+                      int32_t* __restrict hx, int32_t* __restrict hy,
+                      int32_t* __restrict dx, int32_t* __restrict dy, int32_t* __restrict next) {
+    for (int e = 0; e < n; ++e) {
+        int a = act[e];
+        int ax = (a == SNAKE_ENV_RIGHT) - (a == SNAKE_ENV_LEFT);
+        int ay = (a == SNAKE_ENV_DOWN) - (a == SNAKE_ENV_UP);
+        int keep = -((ax == -dx[e]) & (ay == -dy[e])); // all ones on a reversal
+        keep |= -(a > SNAKE_ENV_LEFT); // and on a bad action
+        int x = hx[e] + (dx[e] = (dx[e] & keep) | (ax & ~keep));
+        int y = hy[e] + (dy[e] = (dy[e] & keep) | (ay & ~keep));
+        hx[e] = x;
+        hy[e] = y;
+        int inside = ((unsigned)x < (unsigned)cols) & ((unsigned)y < (unsigned)rows);
+        next[e] = (y * cols + x) | (inside - 1);
+    }
+}
+
+void SnakeEnvStep(SnakeEnv* env, const unsigned char* actions, float* rewards, unsigned char* dones) {
+    const int n = env->count, cells = env->cells;
+    const int32_t* next = env->next.data();
+    MoveHeads(n, env->cols, env->rows, actions, env->headX.data(), env->headY.data(),
+              env->dirX.data(), env->dirY.data(), env->next.data());
+    // collisions and bodies: one bitboard lookup per game
+    for (int e = 0; e < n; ++e) {
+        uint64_t* occ = &env->occ[(size_t)e * env->words];
+        uint8_t* obs = &env->obs[(size_t)e * cells];
+        uint16_t* body = &env->body[(size_t)e * cells];
+        int c = next[e];
+        // the tail still counts, as in Tick
+        if (c < 0 || Occupied(occ, c)) {
+            rewards[e] = -1;
+            dones[e] = 1;
+            ResetGame(env, e);
+            continue;
+        }
+        int h = env->head[e];
+        obs[body[h]] = SNAKE_ENV_BODY;
+        h = h + 1 == cells ? 0 : h + 1;
+        env->head[e] = h;
+        body[h] = (uint16_t)c;
+        occ[c >> 6] |= 1ull << (c & 63);
+        obs[c] = SNAKE_ENV_HEAD;
+        rewards[e] = 0;
+        dones[e] = 0;
+        if (c == env->food[e]) {
+            ++env->len[e];
+            rewards[e] = 1;
+            if (!PlaceFood(env, e)) {
+                // full board, nothing left to win
+                env->food[e] = -1;
+                dones[e] = 1;
+                ResetGame(env, e);
+            }
+            continue;
+        }
+        int t = body[(h - env->len[e] + cells) % cells];
+        occ[t >> 6] &= ~(1ull << (t & 63));
+        obs[t] = SNAKE_ENV_EMPTY;
+    }
+}
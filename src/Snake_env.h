@@ -0,0 +1,43 @@
+#pragma once
+
+// Batched, windowless snake for training agents. One SnakeEnv holds `count`
+// independent games as arrays (heads, directions, ring-buffer bodies,
+// occupancy bitboards, food) and SnakeEnvStep advances all of them at once.
+// Rules are the Classic mode on an open board: the edge and the snake kill,
+// food grows the snake by one. Plain C so any language can load it (the
+// Env build target makes it a shared library without SDL).
+#if defined(_WIN32) && defined(SNAKE_ENV_DLL)
+#define SNAKE_ENV_API __declspec(dllexport)
+#else
+#define SNAKE_ENV_API
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct SnakeEnv SnakeEnv;
+
+// Actions (a reversal or a value above SNAKE_ENV_LEFT is ignored, the snake
+// keeps going) and cell values of the observation grid.
+enum { SNAKE_ENV_UP, SNAKE_ENV_RIGHT, SNAKE_ENV_DOWN, SNAKE_ENV_LEFT };
+enum { SNAKE_ENV_EMPTY, SNAKE_ENV_BODY, SNAKE_ENV_HEAD, SNAKE_ENV_FOOD };
+
+// cols * rows must stay below 65536. Returns NULL on bad arguments.
+SNAKE_ENV_API SnakeEnv* SnakeEnvCreate(int count, int cols, int rows, unsigned seed);
+SNAKE_ENV_API void SnakeEnvDestroy(SnakeEnv* env);
+SNAKE_ENV_API void SnakeEnvReset(SnakeEnv* env);
+// count * cols * rows bytes, one row-major grid per game, kept up to date
+// in place by every step (no copy).
+SNAKE_ENV_API const unsigned char* SnakeEnvObservations(const SnakeEnv* env);
+// actions: one per game, out of range ones keep the current direction.
+// rewards get +1 for food, -1 for a death, 0 otherwise; dones get 1 when
+// the game ended this step (death or a full board). Ended games restart
+// right away, their observation is the new game.
+SNAKE_ENV_API void SnakeEnvStep(SnakeEnv* env, const unsigned char* actions, float* rewards, unsigned char* dones);
+// Snake length of game i.
+SNAKE_ENV_API int SnakeEnvLength(const SnakeEnv* env, int i);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,97 @@
+#include <cstring>
+#include <string>
+#include "State_share.h"
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+static ShareSegment* gSeg = nullptr;
+static std::string gName;
+#ifdef _WIN32
+static HANDLE gMapping = nullptr;
+#endif
+
+static void* MapSegment(const char* name) {
+#ifdef _WIN32
+    gMapping = CreateFileMappingA(INVALID_HANDLE_VALUE, nullptr, PAGE_READWRITE, 0, sizeof(ShareSegment), name);
+    if (gMapping == nullptr) return nullptr;
+    return MapViewOfFile(gMapping, FILE_MAP_ALL_ACCESS, 0, 0, sizeof(ShareSegment));
+#else
+    // POSIX names start with one slash
+    gName = name[0] == '/' ? name : std::string("/") + name;
+    int fd = shm_open(gName.c_str(), O_CREAT | O_RDWR, 0600);
+    if (fd < 0) return nullptr;
+    if (ftruncate(fd, sizeof(ShareSegment)) != 0) { close(fd); return nullptr; }
+    void* p = mmap(nullptr, sizeof(ShareSegment), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+    return p == MAP_FAILED ? nullptr : p;
+#endif
+}
+
+bool ShareOpen(const char* name) {
+    ShareClose();
+    gSeg = static_cast<ShareSegment*>(MapSegment(name));
+    if (gSeg == nullptr) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Cannot create shared state segment %s", name);
+        ShareClose();
+        return false;
+    }
+    // a segment left over from an earlier run starts clean, the magic goes
+    // in last so a bot waiting for it sees a consistent segment
+    gSeg->magic = 0;
+    SDL_MemoryBarrierRelease();
+    memset(&gSeg->state, 0, sizeof(gSeg->state));
+    gSeg->state.fake = -1;
+    SDL_AtomicSet(&gSeg->seq, 0);
+    SDL_AtomicSet(&gSeg->inHead, 0);
+    SDL_AtomicSet(&gSeg->inTail, 0);
+    gSeg->version = SHARE_VERSION;
+    SDL_MemoryBarrierRelease();
+    gSeg->magic = SHARE_MAGIC;
+    SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO, "Sharing game state in %s (%u bytes)",
+                   name, (unsigned)sizeof(ShareSegment));
+    return true;
+}
+
+void ShareClose() {
+#ifdef _WIN32
+    if (gSeg) UnmapViewOfFile(gSeg);
+    if (gMapping) CloseHandle(gMapping);
+    gMapping = nullptr;
+#else
+    if (gSeg) munmap(gSeg, sizeof(ShareSegment));
+    if (!gName.empty()) shm_unlink(gName.c_str());
+    gName.clear();
+#endif
+    gSeg = nullptr;
+}
+
+bool ShareActive() {
+    return gSeg != nullptr;
+}
+
+ShareState* ShareBegin() {
+    if (!gSeg) return nullptr;
+    SDL_AtomicAdd(&gSeg->seq, 1);
+    SDL_MemoryBarrierRelease();
+    return &gSeg->state;
+}
+
+void ShareCommit() {
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicAdd(&gSeg->seq, 1);
+}
+
+bool SharePollInput(int& dir) {
+    if (!gSeg) return false;
+    int tail = SDL_AtomicGet(&gSeg->inTail);
+    if (tail == SDL_AtomicGet(&gSeg->inHead)) return false;
+    SDL_MemoryBarrierAcquire();
+    dir = gSeg->input[tail & (SHARE_INPUT_RING - 1)];
+    SDL_AtomicSet(&gSeg->inTail, tail + 1);
+    return true;
+}
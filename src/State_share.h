@@ -0,0 +1,50 @@
+#pragma once
+#include <SDL.h>
+
+// Game state export for out-of-process bots and observers (--share NAME).
+// One shared-memory segment holds the board state of the latest tick behind
+// a seqlock and an input ring the bot writes directions into. The layout
+// below is the protocol: plain fixed-size fields, cells as row-major indices
+// (y * cols + x), so a reader in any language can map it and use it in place.
+const Uint32 SHARE_MAGIC     = 0x534B4E53; // "SNKS"
+const Uint32 SHARE_VERSION   = 1;
+const int    SHARE_MAX_CELLS = 128 * 128;  // largest board
+const int    SHARE_INPUT_RING = 64;        // power of two
+
+enum { SHARE_NO_GAME, SHARE_RUNNING, SHARE_DEAD };
+// Directions in the input ring.
+enum { SHARE_UP, SHARE_RIGHT, SHARE_DOWN, SHARE_LEFT };
+
+struct ShareState {
+    Uint64 tick;       // ticks since the game started, goes back on rewind
+    Sint32 status;     // SHARE_NO_GAME, SHARE_RUNNING, SHARE_DEAD
+    Sint32 cols, rows;
+    Sint32 score;
+    Sint32 dirX, dirY; // -1, 0 or 1
+    Sint32 food, fake; // cells, fake is -1 when the mode has none
+    Sint32 fakeIsFood; // Two-Layer: the fake turned real after it was crossed
+    Sint32 len;
+    Uint16 body[SHARE_MAX_CELLS]; // head first
+};
+
+struct ShareSegment {
+    Uint32 magic, version;
+    // seqlock: odd while the game writes `state`. Readers copy what they
+    // need and retry if seq was odd or changed meanwhile.
+    SDL_atomic_t seq;
+    Uint32 pad0;
+    ShareState state;
+    // single-producer (bot) single-consumer (game) ring of SHARE_* directions
+    SDL_atomic_t inHead; // written by the bot
+    SDL_atomic_t inTail; // written by the game
+    Uint8 input[SHARE_INPUT_RING];
+};
+
+bool ShareOpen(const char* name);
+void ShareClose();
+bool ShareActive();
+// Writable state, then ShareCommit to publish it. Only the game thread writes.
+ShareState* ShareBegin();
+void ShareCommit();
+// Next direction from the bot; false when the ring is empty.
+bool SharePollInput(int& dir);
@@ -0,0 +1,127 @@
+#include <SDL.h>
+#include <cstdio>
+#include <cstring>
+#include "Telemetry.h"
+
+struct TelemetryEvent {
+    Uint32 time;
+    int type, a, b;
+    char text[48];
+};
+
+// Bounded MPMC queue (Vyukov): each slot carries a sequence number that
+// says whether it is free for the producer at `pos` or ready for the reader.
+struct TelemetrySlot {
+    SDL_atomic_t seq;
+    TelemetryEvent ev;
+};
+
+static TelemetrySlot gSlots[TELEMETRY_RING_SIZE];
+static SDL_atomic_t gEnqueue;
+static int gDequeue = 0; // writer thread only
+static SDL_atomic_t gDropped;
+static SDL_atomic_t gRunning;
+static bool gStarted = false;
+static SDL_Thread* gWriter = nullptr;
+static FILE* gFile = nullptr;
+
+void TelemetryPush(TelemetryType type, int a, int b, const char* text) {
+    if (!gStarted) return;
+    int pos = SDL_AtomicGet(&gEnqueue);
+    TelemetrySlot* slot;
+    while (true) {
+        slot = &gSlots[pos & (TELEMETRY_RING_SIZE - 1)];
+        int dif = SDL_AtomicGet(&slot->seq) - pos;
+        if (dif == 0) {
+            if (SDL_AtomicCAS(&gEnqueue, pos, pos + 1)) break;
+        }
+        else if (dif < 0) {
+            SDL_AtomicAdd(&gDropped, 1);
+            return;
+        }
+        pos = SDL_AtomicGet(&gEnqueue);
+    }
+    slot->ev.time = SDL_GetTicks();
+    slot->ev.type = type;
+    slot->ev.a = a;
+    slot->ev.b = b;
+    slot->ev.text[0] = 0;
+    if (text) {
+        strncpy(slot->ev.text, text, sizeof(slot->ev.text) - 1);
+        slot->ev.text[sizeof(slot->ev.text) - 1] = 0;
+    }
+    SDL_MemoryBarrierRelease();
+    SDL_AtomicSet(&slot->seq, pos + 1);
+}
+
+int TelemetryUsSince(unsigned long long counterStart) {
+    return (int)((SDL_GetPerformanceCounter() - counterStart) * 1000000 / SDL_GetPerformanceFrequency());
+}
+
+static void WriteEvent(const TelemetryEvent& e) {
+    switch (e.type) {
+    case TEL_GAME_START:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"game_start\",\"mode\":\"%s\"}\n", e.time, e.text); break;
+    case TEL_GAME_END:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"game_end\",\"score\":%d,\"length\":%d}\n", e.time, e.a, e.b); break;
+    case TEL_FOOD:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"food\",\"score\":%d,\"time_to_eat_ms\":%d}\n", e.time, e.a, e.b); break;
+    case TEL_DEATH:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"death\",\"score\":%d,\"cause\":\"%s\"}\n", e.time, e.a, e.text); break;
+    case TEL_FRAME_SPIKE:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"frame_spike\",\"us\":%d}\n", e.time, e.a); break;
+    case TEL_ASSET:
+        fprintf(gFile, "{\"t\":%u,\"ev\":\"asset\",\"file\":\"%s\",\"us\":%d}\n", e.time, e.text, e.a); break;
+    }
+}
+
+static int Drain() {
+    int n = 0;
+    while (true) {
+        TelemetrySlot* slot = &gSlots[gDequeue & (TELEMETRY_RING_SIZE - 1)];
+        if (SDL_AtomicGet(&slot->seq) - (gDequeue + 1) < 0) break;
+        SDL_MemoryBarrierAcquire();
+        WriteEvent(slot->ev);
+        SDL_AtomicSet(&slot->seq, gDequeue + TELEMETRY_RING_SIZE);
+        ++gDequeue;
+        ++n;
+    }
+    return n;
+}
+
+static int WriterThread(void*) {
+    while (SDL_AtomicGet(&gRunning)) {
+        if (Drain() > 0) fflush(gFile);
+        SDL_Delay(100);
+    }
+    Drain();
+    return 0;
+}
+
+bool TelemetryStart(const char* path) {
+    if (gStarted) return true;
+    gFile = fopen(path, "w");
+    if (gFile == nullptr) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Cannot open telemetry file %s", path);
+        return false;
+    }
+    for (int i = 0; i < TELEMETRY_RING_SIZE; ++i) SDL_AtomicSet(&gSlots[i].seq, i);
+    SDL_AtomicSet(&gEnqueue, 0);
+    SDL_AtomicSet(&gDropped, 0);
+    SDL_AtomicSet(&gRunning, 1);
+    gDequeue = 0;
+    gWriter = SDL_CreateThread(WriterThread, "telemetry", nullptr);
+    gStarted = true;
+    return true;
+}
+
+void TelemetryStop() {
+    if (!gStarted) return;
+    gStarted = false;
+    SDL_AtomicSet(&gRunning, 0);
+    SDL_WaitThread(gWriter, nullptr);
+    int dropped = SDL_AtomicGet(&gDropped);
+    if (dropped) fprintf(gFile, "{\"ev\":\"dropped\",\"count\":%d}\n", dropped);
+    fclose(gFile);
+    gFile = nullptr;
+}
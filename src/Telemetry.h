@@ -0,0 +1,21 @@
+#pragma once
+
+// Structured session telemetry. Events are fixed-size records pushed into a
+// lock-free ring; a background thread formats them as JSON lines. Pushing
+// never blocks or allocates: when the ring is full the event is dropped.
+enum TelemetryType {
+    TEL_GAME_START,  // text = mode name
+    TEL_GAME_END,    // a = score, b = snake length
+    TEL_FOOD,        // a = score after eating, b = ms since the food appeared
+    TEL_DEATH,       // a = score, text = cause
+    TEL_FRAME_SPIKE, // a = frame work time in us
+    TEL_ASSET        // a = load time in us, text = file
+};
+
+const int TELEMETRY_RING_SIZE = 4096; // power of two
+
+bool TelemetryStart(const char* path);
+void TelemetryStop();
+void TelemetryPush(TelemetryType type, int a = 0, int b = 0, const char* text = nullptr);
+// Microseconds since an SDL_GetPerformanceCounter() value.
+int TelemetryUsSince(unsigned long long counterStart);
@@ -0,0 +1,118 @@
+#include "Timer_wheel.h"
+using namespace std;
+
+const int WHEEL_OVERFLOW = WHEEL_LEVELS * WHEEL_SLOTS;
+const int WHEEL_EXPIRED  = WHEEL_OVERFLOW + 1;
+const int ID_INDEX_BITS  = 20; // node index + 1 in the low bits, generation above
+const unsigned ID_INDEX_MASK = (1u << ID_INDEX_BITS) - 1;
+const unsigned ID_GEN_MASK   = (1u << (32 - ID_INDEX_BITS)) - 1;
+
+static void Link(TimerWheel& w, int i, int list) {
+    TimerWheel::Node& n = w.nodes[i];
+    n.list = list;
+    n.prev = -1;
+    n.next = w.heads[list];
+    if (n.next >= 0) w.nodes[n.next].prev = i;
+    w.heads[list] = i;
+}
+
+static void Unlink(TimerWheel& w, int i) {
+    TimerWheel::Node& n = w.nodes[i];
+    if (n.prev >= 0) w.nodes[n.prev].next = n.next;
+    else w.heads[n.list] = n.next;
+    if (n.next >= 0) w.nodes[n.next].prev = n.prev;
+}
+
+// The lowest level whose range holds the due tick, relative to the clock.
+static void Place(TimerWheel& w, int i) {
+    unsigned long long due = w.nodes[i].due;
+    if (due <= w.now) { Link(w, i, WHEEL_EXPIRED); return; }
+    unsigned long long delta = due - w.now;
+    for (int level = 0; level < WHEEL_LEVELS; ++level) {
+        if (delta < 1ull << (WHEEL_BITS * (level + 1))) {
+            Link(w, i, level * WHEEL_SLOTS + (int)((due >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)));
+            return;
+        }
+    }
+    Link(w, i, WHEEL_OVERFLOW);
+}
+
+// Empties `list` and places its timers again, one level lower now.
+static void Cascade(TimerWheel& w, int list) {
+    int i = w.heads[list];
+    w.heads[list] = -1;
+    while (i >= 0) {
+        int next = w.nodes[i].next;
+        Place(w, i);
+        i = next;
+    }
+}
+
+void TimerReset(TimerWheel& w, int capacity, unsigned long long now) {
+    if (capacity > (int)ID_INDEX_MASK - 1) capacity = ID_INDEX_MASK - 1;
+    w.nodes.assign(capacity, TimerWheel::Node());
+    for (int i = 0; i < capacity; ++i) {
+        w.nodes[i].next = i + 1 < capacity ? i + 1 : -1;
+        w.nodes[i].list = -1;
+    }
+    w.freeHead = capacity ? 0 : -1;
+    for (int& h : w.heads) h = -1;
+    w.now = now;
+    w.count = 0;
+}
+
+TimerId TimerAdd(TimerWheel& w, unsigned long long due, int data) {
+    int i = w.freeHead;
+    if (i < 0 || data < 0) return 0;
+    w.freeHead = w.nodes[i].next;
+    TimerWheel::Node& n = w.nodes[i];
+    n.due = due;
+    n.data = data;
+    n.gen = (n.gen + 1) & ID_GEN_MASK;
+    Place(w, i);
+    ++w.count;
+    return n.gen << ID_INDEX_BITS | (unsigned)(i + 1);
+}
+
+static void Release(TimerWheel& w, int i) {
+    w.nodes[i].list = -1;
+    w.nodes[i].next = w.freeHead;
+    w.freeHead = i;
+    --w.count;
+}
+
+bool TimerCancel(TimerWheel& w, TimerId id) {
+    int i = (int)(id & ID_INDEX_MASK) - 1;
+    if (i < 0 || i >= (int)w.nodes.size()) return false;
+    TimerWheel::Node& n = w.nodes[i];
+    if (n.list < 0 || n.gen != id >> ID_INDEX_BITS) return false;
+    Unlink(w, i);
+    Release(w, i);
+    return true;
+}
+
+int TimerPop(TimerWheel& w, unsigned long long tick) {
+    while (w.heads[WHEEL_EXPIRED] < 0 && w.now < tick) {
+        if (w.count == 0) { w.now = tick; break; } // nothing to cascade on the way
+        unsigned long long now = ++w.now;
+        // a level wrapped: the next slot of the level above comes down,
+        // top level first so its timers can go on down with the one below
+        for (int level = WHEEL_LEVELS; level >= 1; --level) {
+            if (now & ((1ull << (WHEEL_BITS * level)) - 1)) continue;
+            if (level == WHEEL_LEVELS) Cascade(w, WHEEL_OVERFLOW);
+            else Cascade(w, level * WHEEL_SLOTS + (int)((now >> (WHEEL_BITS * level)) & (WHEEL_SLOTS - 1)));
+        }
+        int slot = (int)(now & (WHEEL_SLOTS - 1));
+        while (w.heads[slot] >= 0) {
+            int i = w.heads[slot];
+            Unlink(w, i);
+            Link(w, i, WHEEL_EXPIRED);
+        }
+    }
+    int i = w.heads[WHEEL_EXPIRED];
+    if (i < 0) return -1;
+    int data = w.nodes[i].data;
+    Unlink(w, i);
+    Release(w, i);
+    return data;
+}
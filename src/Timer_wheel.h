@@ -0,0 +1,43 @@
+#pragma once
+#include <vector>
+
+// Hierarchical timing wheel keyed by tick number. Four levels of 64 slots
+// cover 2^24 ticks ahead, timers further out wait in an overflow list.
+// Adding and cancelling is O(1), advancing by one tick only looks at the
+// slot that tick falls on, plus a cascade of one higher slot every 64
+// ticks, so the cost per tick does not grow with the number of pending
+// timers. Timers come from a pool sized by TimerReset, nothing allocates
+// afterwards.
+const int WHEEL_BITS   = 6;
+const int WHEEL_SLOTS  = 1 << WHEEL_BITS;
+const int WHEEL_LEVELS = 4;
+
+// 0 is never a valid id. Ids carry a generation, so cancelling a timer that
+// already fired (and whose node was reused) does nothing.
+typedef unsigned TimerId;
+
+struct TimerWheel {
+    struct Node {
+        unsigned long long due;
+        int data;
+        int prev, next; // in the list of `list`, -1 at the ends
+        int list;       // slot, WHEEL_OVERFLOW or WHEEL_EXPIRED; -1 while free
+        unsigned gen;
+    };
+    std::vector<Node> nodes;
+    int freeHead = -1;
+    int heads[WHEEL_LEVELS * WHEEL_SLOTS + 2];
+    unsigned long long now = 0;
+    int count = 0; // pending, including expired ones not popped yet
+};
+
+// Empties the wheel, makes room for `capacity` timers and sets the clock.
+void TimerReset(TimerWheel& w, int capacity, unsigned long long now = 0);
+// `data` (>= 0) comes back from TimerPop once the clock reaches `due`; a due
+// tick in the past fires on the next pop. Returns 0 when the pool is full.
+TimerId TimerAdd(TimerWheel& w, unsigned long long due, int data);
+// False when the timer already fired or was cancelled.
+bool TimerCancel(TimerWheel& w, TimerId id);
+// Advances the clock up to `tick` until a timer is due and returns its data,
+// -1 once nothing is due at `tick`. Call it in a loop after every tick.
+int TimerPop(TimerWheel& w, unsigned long long tick);
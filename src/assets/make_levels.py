@@ -0,0 +1,112 @@
+#!/usr/bin/env python3
+"""Builds levels.pak, the obstacle level pack read by Level_pack.cpp.
+
+Layout (little endian):
+  header    "SNKL", u16 version = 1, u16 count, u32 dir offset, u32 reserved
+  directory count x (u32 offset, u32 size)
+  level     char name[24], u16 cols, u16 rows, u32 wall count,
+            one bit per cell, row-major, bit k of byte k/8 (LSB first)
+Every level keeps the start cell and its row free.
+"""
+import struct
+import sys
+
+COLS, ROWS = 30, 40
+START = (COLS // 2, ROWS // 2)
+
+
+def border(w):
+    for x in range(COLS):
+        w.add((x, 0)); w.add((x, ROWS - 1))
+    for y in range(ROWS):
+        w.add((0, y)); w.add((COLS - 1, y))
+
+
+def box(w, x0, y0, x1, y1):
+    for x in range(x0, x1 + 1):
+        w.add((x, y0)); w.add((x, y1))
+    for y in range(y0, y1 + 1):
+        w.add((x0, y)); w.add((x1, y))
+
+
+def level_border(w): border(w)
+def level_cross(w):
+    for y in range(5, ROWS - 5):
+        w.add((COLS // 2 - 8, y)); w.add((COLS // 2 + 8, y))
+def level_pillars(w):
+    for y in range(4, ROWS - 4, 6):
+        for x in range(4, COLS - 4, 6):
+            for dx in range(2):
+                for dy in range(2):
+                    w.add((x + dx, y + dy))
+def level_rooms(w):
+    border(w)
+    for y in range(ROWS):
+        if y % 10 not in (4, 5): w.add((COLS // 3, y)); w.add((2 * COLS // 3, y))
+def level_bars(w):
+    for y in range(6, ROWS - 6, 7):
+        for x in range(3, COLS - 3):
+            w.add((x, y))
+def level_frames(w):
+    box(w, 3, 3, COLS - 4, ROWS - 4)
+    box(w, 8, 8, COLS - 9, ROWS - 9)
+    for x in range(COLS // 2 - 2, COLS // 2 + 2):  # doors top and bottom
+        for y in (3, 8, ROWS - 9, ROWS - 4):
+            w.discard((x, y))
+def level_zigzag(w):
+    for i, y in enumerate(range(4, ROWS - 4, 4)):
+        xs = range(0, COLS - 6) if i % 2 == 0 else range(6, COLS)
+        for x in xs: w.add((x, y))
+def level_spiral(w):
+    x0, y0, x1, y1 = 2, 2, COLS - 3, ROWS - 3
+    while x1 - x0 > 4 and y1 - y0 > 4:
+        box(w, x0, y0, x1, y1)
+        w.discard((x0, y0 + 2)); w.discard((x1, y1 - 2))
+        x0 += 4; y0 += 4; x1 -= 4; y1 -= 4
+def level_checker(w):
+    for y in range(2, ROWS - 2, 4):
+        for x in range(2 + (y // 4) % 2 * 2, COLS - 2, 4):
+            w.add((x, y))
+
+BASES = [("Border", level_border), ("Two Walls", level_cross), ("Pillars", level_pillars),
+         ("Rooms", level_rooms), ("Bars", level_bars), ("Frames", level_frames),
+         ("Zigzag", level_zigzag), ("Spiral", level_spiral), ("Checker", level_checker)]
+
+
+def build():
+    levels = []
+    for name, fn in BASES:
+        w = set(); fn(w); levels.append((name, w))
+    # bordered variants of the open layouts
+    for name, fn in BASES[1:]:
+        w = set(); fn(w); border(w); levels.append((name + " Box", w))
+    # mirrored variants
+    for name, fn in BASES[2:9]:
+        w = set(); fn(w); levels.append((name + " Flip", {(COLS - 1 - x, ROWS - 1 - y) for x, y in w}))
+    out = []
+    for name, w in levels:
+        w = {c for c in w if c[1] != START[1] or c in ((0, START[1]), (COLS - 1, START[1]))}
+        w.discard(START); w.discard((START[0] + 1, START[1]))
+        bits = bytearray((COLS * ROWS + 7) // 8)
+        for x, y in w:
+            k = y * COLS + x
+            bits[k >> 3] |= 1 << (k & 7)
+        out.append(struct.pack("<24sHHI", name.encode()[:23], COLS, ROWS, len(w)) + bytes(bits))
+    return out
+
+
+def main(path):
+    blocks = build()
+    header = struct.pack("<4sHHII", b"SNKL", 1, len(blocks), 16, 0)
+    offset = 16 + 8 * len(blocks)
+    directory = b""
+    for b in blocks:
+        directory += struct.pack("<II", offset, len(b))
+        offset += len(b)
+    with open(path, "wb") as f:
+        f.write(header + directory + b"".join(blocks))
+    print("%d levels written to %s" % (len(blocks), path))
+
+
+if __name__ == "__main__":
+    main(sys.argv[1] if len(sys.argv) > 1 else "levels.pak")
@@ -0,0 +1,72 @@
+#!/usr/bin/env python3
+"""Golden-frame render check for the game (--render-check in main.cpp).
+
+The frame hashes depend on the SDL build, so the golden file is per
+platform: assets/golden/<platform>.txt. Two ways to run it:
+
+  # against the committed golden file of this platform
+  python3 assets/run_render_check.py bin/Release/Game03
+  # (re)write it on the reference machine, then commit the file
+  python3 assets/run_render_check.py bin/Release/Game03 --update
+
+  # CI without a committed file for the runner: build the target branch
+  # first, its frames become the golden file, then check the change
+  python3 assets/run_render_check.py build/head/Game03 --reference-exe build/base/Game03
+
+Run it from the src directory, the game loads its assets from there. The
+exit code is 1 when a frame differs, a golden hash is missing, the golden
+file does not exist (without --update) or a render path could not be set up.
+"""
+import argparse
+import os
+import platform
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+GOLDEN_DIR = os.path.join(HERE, "golden")
+TIMEOUT_S = 300
+
+
+def golden_path():
+    name = "%s-%s.txt" % (sys.platform, platform.machine().lower() or "unknown")
+    return os.path.join(GOLDEN_DIR, name)
+
+
+def render_check(exe, golden, update=False):
+    env = dict(os.environ, SDL_VIDEODRIVER="dummy", SDL_AUDIODRIVER="dummy")
+    cmd = [exe, "--render-check", golden] + (["--update"] if update else [])
+    return subprocess.run(cmd, env=env, timeout=TIMEOUT_S).returncode
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("exe", help="game executable to check")
+    ap.add_argument("--golden", default=golden_path(), help="golden file (default: this platform's)")
+    ap.add_argument("--update", action="store_true", help="write the golden file from exe")
+    ap.add_argument("--reference-exe", help="build whose frames are the golden ones (e.g. the target branch)")
+    args = ap.parse_args()
+
+    if args.update:
+        os.makedirs(os.path.dirname(os.path.abspath(args.golden)), exist_ok=True)
+        return render_check(args.exe, args.golden, update=True)
+    if args.reference_exe:
+        fd, golden = tempfile.mkstemp(suffix=".txt")
+        os.close(fd)
+        try:
+            if render_check(args.reference_exe, golden, update=True) != 0:
+                print("reference build failed its own render check")
+                return 1
+            return render_check(args.exe, golden)
+        finally:
+            os.remove(golden)
+    if not os.path.exists(args.golden):
+        print("no golden file %s: run with --update on the reference machine and commit it,"
+              " or use --reference-exe" % args.golden)
+        return 1
+    return render_check(args.exe, args.golden)
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,129 @@
+#!/usr/bin/env python3
+"""Performance regression scenarios for the game (Scenario.h).
+
+Starts the real executable under the SDL dummy video and audio drivers,
+plays each script in assets/scenarios with --script, collects the
+--perf-report JSON and compares it against a stored baseline.
+
+  python3 assets/run_scenarios.py bin/Release/Game03            # compare
+  python3 assets/run_scenarios.py bin/Release/Game03 --update   # new baseline
+  python3 assets/run_scenarios.py bin/Debug/Game03 --only menu  # with allocations
+
+Run it from the src directory, the game loads its assets from there. Every
+scenario runs --runs times and the median of each metric is used, so one
+noisy run does not fail the check. The exit code is 1 when a metric got
+worse than the baseline by more than its tolerance.
+"""
+import argparse
+import json
+import os
+import statistics
+import subprocess
+import sys
+import tempfile
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+SCENARIO_DIR = os.path.join(HERE, "scenarios")
+BASELINE = os.path.join(SCENARIO_DIR, "baseline.json")
+
+# name: (script, extra game arguments)
+SCENARIOS = {
+    "menu": ("menu.txt", []),
+    "classic500": ("classic500.txt", ["--turbo"]),
+    "twolayer": ("twolayer.txt", ["--turbo"]),
+    "pause_spam": ("pause_spam.txt", ["--turbo"]),
+    "versus": ("versus.txt", ["--turbo"]),
+}
+
+# metric: (relative tolerance, absolute slack); higher is worse for all of them
+TOLERANCES = {
+    "frame_us_p50": (0.20, 50),
+    "frame_us_p95": (0.25, 100),
+    "frame_us_p99": (0.35, 200),
+    "tick_ns_mean": (0.20, 50),
+    "allocations_per_frame": (0.0, 0.5),
+    "peak_rss_kb": (0.10, 2048),
+}
+
+TIMEOUT_S = 300
+
+
+def run_once(exe, name):
+    script, extra = SCENARIOS[name]
+    env = dict(os.environ, SDL_VIDEODRIVER="dummy", SDL_AUDIODRIVER="dummy")
+    fd, report = tempfile.mkstemp(suffix=".json")
+    os.close(fd)
+    try:
+        cmd = [exe, "--script", os.path.join(SCENARIO_DIR, script), "--perf-report", report] + extra
+        subprocess.run(cmd, env=env, timeout=TIMEOUT_S, check=True,
+                       stdout=subprocess.DEVNULL, stderr=subprocess.DEVNULL)
+        with open(report) as f:
+            return json.load(f)
+    finally:
+        os.remove(report)
+
+
+def median_report(runs):
+    out = {}
+    for key in runs[0]:
+        values = [r[key] for r in runs if r[key] is not None]
+        out[key] = statistics.median(values) if values else None
+    return out
+
+
+def compare(name, now, base):
+    failed = False
+    for metric, (rel, slack) in TOLERANCES.items():
+        a, b = base.get(metric), now.get(metric)
+        if a is None or b is None:
+            continue
+        limit = a * (1 + rel) + slack
+        bad = b > limit
+        failed |= bad
+        print("  %-22s %12.1f  baseline %12.1f  limit %12.1f  %s"
+              % (metric, b, a, limit, "REGRESSION" if bad else "ok"))
+    return failed
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    ap.add_argument("exe", help="game executable")
+    ap.add_argument("--runs", type=int, default=3)
+    ap.add_argument("--only", action="append", choices=sorted(SCENARIOS))
+    ap.add_argument("--baseline", default=BASELINE)
+    ap.add_argument("--update", action="store_true", help="store the results as the new baseline")
+    args = ap.parse_args()
+
+    baseline = {}
+    if os.path.exists(args.baseline):
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+
+    results, failed = {}, False
+    for name in args.only or SCENARIOS:
+        try:
+            runs = [run_once(args.exe, name) for _ in range(args.runs)]
+        except (subprocess.SubprocessError, OSError, ValueError) as e:
+            print("%s: FAILED (%s)" % (name, e))
+            failed = True
+            continue
+        results[name] = median_report(runs)
+        r = results[name]
+        print("%s: %d frames, p95 %d us, %d ticks at %.0f ns, peak %d KB"
+              % (name, r["frames"], r["frame_us_p95"], r["ticks"], r["tick_ns_mean"], r["peak_rss_kb"]))
+        if not args.update and name in baseline:
+            failed |= compare(name, r, baseline[name])
+
+    if args.update:
+        baseline.update(results)
+        with open(args.baseline, "w") as f:
+            json.dump(baseline, f, indent=2, sort_keys=True)
+        print("baseline written to", args.baseline)
+        return 0
+    if not baseline:
+        print("no baseline yet, run with --update on the reference machine")
+    return 1 if failed else 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
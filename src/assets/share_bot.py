@@ -0,0 +1,102 @@
+#!/usr/bin/env python3
+"""Example bot for --share NAME (protocol in State_share.h).
+
+Maps the segment, reads every new tick through the seqlock and answers with
+the first step of a shortest path to the food (breadth-first over the free
+cells), or any free neighbour when the food cannot be reached.
+
+  Game03 --share snake &
+  python3 assets/share_bot.py snake
+
+Layout (little endian, offsets in bytes):
+  0   u32 magic "SNKS", u32 version = 1, i32 seq, u32 pad
+  16  u64 tick, i32 status, cols, rows, score, dirX, dirY, food, fake,
+      fakeIsFood, len, u16 body[16384] (head first)
+  32832 i32 inHead (bot), i32 inTail (game), u8 input[64]
+"""
+import mmap
+import struct
+import sys
+import time
+from collections import deque
+
+SEG_SIZE = 32904
+STATE = 16
+BODY = STATE + 48
+IN_HEAD, IN_TAIL, INPUT, RING = 32832, 32836, 32840, 64
+STATUS_DEAD = 2
+DIRS = [(0, -1), (1, 0), (0, 1), (-1, 0)]  # SHARE_UP, RIGHT, DOWN, LEFT
+
+
+def open_segment(name):
+    if sys.platform == "win32":
+        return mmap.mmap(-1, SEG_SIZE, tagname=name)
+    with open("/dev/shm/" + name.lstrip("/"), "r+b") as f:
+        return mmap.mmap(f.fileno(), SEG_SIZE)
+
+
+def read_state(m):
+    """Consistent copy of the state, or None while the game is writing."""
+    seq = struct.unpack_from("<i", m, 8)[0]
+    if seq & 1:
+        return None
+    head = struct.unpack_from("<Q10i", m, STATE)
+    length = head[10]
+    body = struct.unpack_from("<%dH" % length, m, BODY)
+    if struct.unpack_from("<i", m, 8)[0] != seq:
+        return None
+    return head, body
+
+
+def choose(cols, rows, food, body):
+    blocked = set(body[:-1])  # the tail moves away this tick
+    hx, hy = body[0] % cols, body[0] // cols
+    first = {}
+    queue = deque()
+    for d, (dx, dy) in enumerate(DIRS):
+        x, y = hx + dx, hy + dy
+        c = y * cols + x
+        if 0 <= x < cols and 0 <= y < rows and c not in blocked:
+            first[c] = d
+            queue.append((x, y))
+    while queue:
+        x, y = queue.popleft()
+        c = y * cols + x
+        if c == food:
+            return first[c]
+        for dx, dy in DIRS:
+            nx, ny = x + dx, y + dy
+            n = ny * cols + nx
+            if 0 <= nx < cols and 0 <= ny < rows and n not in blocked and n not in first:
+                first[n] = first[c]
+                queue.append((nx, ny))
+    return next(iter(first.values()), 0)
+
+
+def main():
+    name = sys.argv[1] if len(sys.argv) > 1 else "snake"
+    m = open_segment(name)
+    if m[0:4] != b"SNKS":
+        sys.exit("%s is not a game state segment" % name)
+    last_tick = None
+    while True:
+        got = read_state(m)
+        if got is None or got[0][0] == last_tick:
+            time.sleep(0.0002)
+            continue
+        (tick, status, cols, rows, score, _, _, food, _, _, length), body = got
+        last_tick = tick
+        if status == STATUS_DEAD:
+            print("dead at tick %d, score %d" % (tick, score))
+            continue
+        if length == 0:
+            continue
+        head_idx, tail_idx = struct.unpack_from("<ii", m, IN_HEAD)
+        if head_idx - tail_idx >= RING:
+            continue
+        m[INPUT + (head_idx & (RING - 1))] = choose(cols, rows, food, body)
+        struct.pack_into("<i", m, IN_HEAD, head_idx + 1)
+
+
+if __name__ == "__main__":
+    main()
@@ -10,47 +10,115 @@
 #include "SDL_utils.h"
 #include "SDL-Mix.h"
 #include "SDL_text.h"
+#include "Game_rules.h"
+#include "Game_bench.h"
+#include "SDL_particles.h"
+#include "Frame_arena.h"
+#include "SDL_softraster.h"
+#include "SDL_capture.h"
+#include "Telemetry.h"
+#include "State_share.h"
+#include "SDL_voices.h"
+#include "SDL_music.h"
+#include "Scenario.h"
+#include "Frame_hash.h"
+#include "Asset_loader.h"
+#include "Level_pack.h"
+#include "Game_history.h"
+#include "Scene.h"
 using namespace std;
-const int SCREEN_WIDTH  = 600;
-const int SCREEN_HEIGHT = 800;
-const int RECT_SIZE     = 20;
 const char* WINDOW_TITLE = "Snake Game";
-enum { MENU_CLASSIC = 1, MENU_TWOLAYER, MENU_QUIT, MENU_RESUME };
-struct Point {
-    int x, y;
-    Point(int x_val, int y_val) : x(x_val), y(y_val) {}
-    Point() : x(0), y(0) {}
-    bool operator==(const Point& o) const { return x==o.x && y==o.y; }
-};
+enum { MENU_CLASSIC = 1, MENU_TWOLAYER, MENU_QUIT, MENU_RESUME, MENU_FEAST, MENU_LEVEL, MENU_BOARD, MENU_POWERUP, MENU_VERSUS };
+const Uint64 MAX_TICK_BACKLOG_US = 250000; // further behind than this, skip ahead
+const Uint64 REWIND_US = 10000000; // how far back holding R can go
 SDL_Texture* gHeadTexture       = nullptr;
 SDL_Texture* gBodyTexture       = nullptr;
 SDL_Texture* gFoodTexture       = nullptr;
 SDL_Texture* gFakeTexture       = nullptr;
 SDL_Texture* gBackgroundTexture = nullptr;
-vector<Point> savedSnake;
-Point savedDir, savedNextDir, savedFood, savedFake;
-bool savedTwoLayer = false;
-bool savedFakeConsumed = false;
-int savedScore = 0;
-Uint32 savedLast = 0;
-Uint32 savedInterval = 150;
-bool paused = false;
-Mix_Music* gMusic = nullptr;
+SDL_Texture* gStaticLayer       = nullptr; // background + walls at the output size
+SDL_Texture* gBoardLayer        = nullptr; // persistent board of the incremental renderer
+GameState gSaved;
+History gHistory; // rewind history of the running game
+int savedMode = MENU_CLASSIC;
+int gLevel = -1; // index in the level pack, -1 is the open board
+// Board sizes a game can be started with (menu or --board), each one is its
+// own instantiation of the game, see MakeGameScene.
+const char* BOARD_NAMES[] = {"20x20", "30x40", "64x64", "128x128"};
+const int BOARD_COUNT = 4, NATIVE_BOARD = 1;
+int gBoard = NATIVE_BOARD;
+int savedBoard = NATIVE_BOARD;
+bool gVsync = false;
+bool gSoftRaster = false; // board layers go through the built-in framebuffer renderer
+bool gTurbo = false;      // stress mode: autopilot and sub-millisecond ticks
+bool gIncremental = false; // repaint only the cells that changed since the last frame
+bool gDeadEnd = false;     // warn when the next move leads into a pocket smaller than the snake
+bool gVersusShared = false; // versus on one board instead of one board each
+int gMenuMusic = -1, gGameMusic = -1; // SDL_music tracks
+const int MUSIC_FADE_MS = 800;
 Mix_Chunk* gEatSound = nullptr;
 Mix_Chunk* gLoseSound = nullptr;
 void QuitSDL(SDL_Window* w, SDL_Renderer* r);
 bool InitSDL(SDL_Window*& w, SDL_Renderer*& r);
-int ShowMenu(SDL_Renderer* ren, TTF_Font* font, bool canResume = false);
-void CoreGame(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font, int mode, bool resuming = false);
+Scene* MakeMenuScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font);
+Scene* MakeGameScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font, int mode, bool resuming);
+Scene* MakeVersusScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font);
+void FreeGameTextures();
+int RunRenderCheck(const char* goldenPath, bool update);
+int RunFrameAllocCheck();
 bool LoadMedia();
 void FreeMedia();
-int ShowPauseMenu(SDL_Renderer* ren, TTF_Font* font); // Pause Menu
 
 int main(int argc, char* argv[]) {
+    if (argc > 2 && string(argv[1]) == "--bench-ticks") return RunTickBenchmark(atoi(argv[2]));
+    if (argc > 2 && string(argv[1]) == "--alloc-check") {
+        int ticks = RunAllocCheck(atoi(argv[2]));
+        if (ticks == 2) return 2; // no tracking in this build
+        return RunFrameAllocCheck() | ticks;
+    }
+    if (argc > 2 && string(argv[1]) == "--bench-raster") return RunRasterBenchmark(atoi(argv[2]));
+    if (argc > 2 && string(argv[1]) == "--bench-env") return RunEnvBenchmark(atoi(argv[2]));
+    if (argc > 2 && string(argv[1]) == "--bench-mixer") return RunMixerBenchmark(atoi(argv[2]));
+    if (argc > 2 && string(argv[1]) == "--bench-timers") return RunTimerBenchmark(atoi(argv[2]));
+    if (argc > 2 && string(argv[1]) == "--render-check") return RunRenderCheck(argv[2], argc > 3 && string(argv[3]) == "--update");
+    const char* recordTarget = nullptr;
+    int recordEvery = 1;
+    for (int i = 1; i < argc; ++i) {
+        if (string(argv[i]) == "--soft-raster") gSoftRaster = true;
+        if (string(argv[i]) == "--turbo") gTurbo = true;
+        if (string(argv[i]) == "--incremental") gIncremental = true;
+        if (string(argv[i]) == "--dead-end") gDeadEnd = true;
+        if (string(argv[i]) == "--board" && i + 1 < argc) {
+            string name = argv[++i];
+            for (int b = 0; b < BOARD_COUNT; ++b) if (name == BOARD_NAMES[b]) gBoard = b;
+        }
+        if (string(argv[i]) == "--record" && i + 1 < argc) recordTarget = argv[++i];
+        if (string(argv[i]) == "--record-every" && i + 1 < argc) recordEvery = atoi(argv[++i]);
+        if (string(argv[i]) == "--telemetry" && i + 1 < argc) TelemetryStart(argv[++i]);
+        if (string(argv[i]) == "--share" && i + 1 < argc) ShareOpen(argv[++i]);
+        if (string(argv[i]) == "--script" && i + 1 < argc && !ScriptLoad(argv[++i])) return 1;
+        if (string(argv[i]) == "--perf-report" && i + 1 < argc) PerfReportStart(argv[++i]);
+    }
     srand((unsigned)time(nullptr));
+    StartupMark("main");
+    // decoding needs neither the window nor the audio device, so images,
+    // sounds and the font load on worker threads while InitSDL opens them
+    if (TTF_Init() != 0) {
+        cerr << "TTF_Init Error: " << TTF_GetError() << endl;
+        return 1;
+    }
+    IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG); // InitSDL reports a failure
+    for (const char* image : {"background.jpg", "head.png", "body.png", "food.png", "fake.png"}) AssetQueueImage(image);
+    AssetQueueFont("timesbd.ttf", 24);
+    AssetQueueSound("assets/eating.wav");
+    AssetQueueSound("assets/lose.wav");
+    AssetsStart();
     SDL_Window* window = nullptr;
     SDL_Renderer* renderer = nullptr;
     if (!InitSDL(window, renderer)) return 1;
+    StartupMark("SDL ready");
+    if (gSoftRaster && !SoftRasterInit(renderer, SCREEN_WIDTH, SCREEN_HEIGHT)) gSoftRaster = false;
+    if (recordTarget) CaptureStart(renderer, recordTarget, recordEvery);
 
     if (!LoadMedia()) {
         SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR, "Error", "Failed to load media!", window);
@@ -58,7 +126,12 @@ int main(int argc, char* argv[]) {
         return 1;
     }
 
-    TTF_Font* font = TTF_OpenFont("timesbd.ttf", 24);
+    TTF_Font* font = AssetTakeFont("timesbd.ttf");
+    if (!font) {
+        Uint64 fontStart = SDL_GetPerformanceCounter();
+        font = TTF_OpenFont("timesbd.ttf", 24);
+        TelemetryPush(TEL_ASSET, TelemetryUsSince(fontStart), 0, "timesbd.ttf");
+    }
     if (!font) {
         cerr << "TTF_OpenFont Error: " << TTF_GetError() << endl;
         QuitSDL(window, renderer);
@@ -71,21 +144,14 @@ int main(int argc, char* argv[]) {
         QuitSDL(window, renderer);
         return 1;
     }
+    if (gSoftRaster) SoftRasterAdd(gBackgroundTexture, "background.jpg", SCREEN_WIDTH, SCREEN_HEIGHT);
+    LevelPackOpen("assets/levels.pak"); // optional, the open board always works
+    StartupMark("media ready");
 
-    if (Mix_PlayingMusic() == 0) {
-        Mix_PlayMusic(gMusic, -1);
-    }
-
-    int mode;
-    bool canResume = false;
-    while ((mode = ShowMenu(renderer, font, canResume)) != MENU_QUIT) {
-        if (mode == MENU_RESUME) {
-            CoreGame(renderer, window, font, savedTwoLayer ? MENU_TWOLAYER : MENU_CLASSIC, true);
-        } else {
-            CoreGame(renderer, window, font, mode);
-        }
-        canResume = !savedSnake.empty();
-    }
+    // menu, game, pause and game over all run on this one loop
+    ScenePush(MakeMenuScene(renderer, window, font));
+    RunScenes(renderer, gVsync);
+    PerfReportWrite();
 
     FreeMedia();
     QuitSDL(window, renderer);
@@ -95,313 +161,1560 @@ int main(int argc, char* argv[]) {
 bool InitSDL(SDL_Window*& w, SDL_Renderer*& r) {
     if (SDL_Init(SDL_INIT_VIDEO | SDL_INIT_AUDIO) != 0) {
         cerr << "SDL_Init Error: " << SDL_GetError() << endl;
+        AssetsQuit();
         return false;
     }
     if (!(IMG_Init(IMG_INIT_PNG) & IMG_INIT_PNG)) {
         cerr << "IMG_Init Error: " << IMG_GetError() << endl;
+        AssetsQuit();
         SDL_Quit();
         return false;
     }
     if (Mix_Init(MIX_INIT_OGG | MIX_INIT_MP3) != (MIX_INIT_OGG | MIX_INIT_MP3)) {  // Initialize both OGG and MP3
         cerr << "Mix_Init Error: " << Mix_GetError() << endl;
+        AssetsQuit();
         IMG_Quit(); SDL_Quit();
         return false;
     }
 
     if (Mix_OpenAudio(44100, MIX_DEFAULT_FORMAT, 2, 2048) < 0) {
         cerr << "Mix_OpenAudio Error: " << Mix_GetError() << endl;
+        AssetsQuit();
         Mix_Quit(); IMG_Quit(); SDL_Quit();
         return false;
     }
-
-    if (TTF_Init() != 0) {
-        cerr << "TTF_Init Error: " << TTF_GetError() << endl;
-        Mix_Quit(); IMG_Quit(); SDL_Quit();
-        return false;
-    }
+    VoicesInit();
+    MusicInit();
+    AssetsAudioOpened(true); // the sound jobs may go on
 
     w = SDL_CreateWindow(WINDOW_TITLE, SDL_WINDOWPOS_CENTERED, SDL_WINDOWPOS_CENTERED,
                          SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_SHOWN);
     r = SDL_CreateRenderer(w, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+    // no GPU (or the dummy video driver of the scenario runs)
+    if (w && !r) r = SDL_CreateRenderer(w, -1, SDL_RENDERER_SOFTWARE);
     if (!w || !r) {
         cerr << "SDL Window/Renderer Error: " << SDL_GetError() << endl;
+        AssetsQuit();
         if (r) SDL_DestroyRenderer(r);
         if (w) SDL_DestroyWindow(w);
         TTF_Quit(); IMG_Quit(); Mix_Quit(); SDL_Quit();
         return false;
     }
+    SDL_RendererInfo info;
+    if (SDL_GetRendererInfo(r, &info) == 0) {
+        gVsync = info.flags & SDL_RENDERER_PRESENTVSYNC;
+        // no GPU: SDL fell back to its software renderer, use ours instead
+        if (info.flags & SDL_RENDERER_SOFTWARE) gSoftRaster = true;
+    }
     return true;
 }
 
 void QuitSDL(SDL_Window* w, SDL_Renderer* r) {
+    CaptureStop();
     FreeMedia();
+    AssetsQuit();
     if (gHeadTexture) SDL_DestroyTexture(gHeadTexture);
     if (gBodyTexture) SDL_DestroyTexture(gBodyTexture);
     if (gFoodTexture) SDL_DestroyTexture(gFoodTexture);
     if (gFakeTexture) SDL_DestroyTexture(gFakeTexture);
     if (gBackgroundTexture) SDL_DestroyTexture(gBackgroundTexture);
+    if (gStaticLayer) SDL_DestroyTexture(gStaticLayer);
+    if (gBoardLayer) SDL_DestroyTexture(gBoardLayer);
+    SoftRasterQuit();
     if (r) SDL_DestroyRenderer(r);
     if (w) SDL_DestroyWindow(w);
     TTF_Quit(); IMG_Quit(); Mix_Quit(); SDL_Quit();
+    LevelPackClose();
+    TelemetryStop();
+    ShareClose();
 }
 
-int ShowMenu(SDL_Renderer* ren, TTF_Font* font, bool canResume) {
-    vector<string> opts = {"Classic Mode","Two-Layer Mode"};
-    if (canResume) {
-        opts.push_back("Resume Game");
-    }
-    opts.push_back("Quit");
+// Microsecond clock for the simulation, SDL_GetTicks is too coarse for turbo.
+Uint64 NowUs() {
+    Uint64 c = SDL_GetPerformanceCounter(), f = SDL_GetPerformanceFrequency();
+    return c / f * 1000000 + c % f * 1000000 / f;
+}
 
-    int sel = 0;
-    SDL_Event e;
-    vector<SDL_Texture*> tex(opts.size());
-    vector<SDL_Rect> dst(opts.size());
+// Menu entries, both colours rendered once so frames only pick one.
+struct MenuList {
+    SDL_Texture* tex[10] = {};
+    SDL_Texture* texSel[10] = {};
+    SDL_Rect dst[10];
+    int n = 0, sel = 0;
 
-    for (size_t i=0;i<opts.size();++i) {
-        tex[i]=renderText(opts[i].c_str(), font, {255,255,255}, ren);
+    void Set(int i, const char* text, TTF_Font* font, SDL_Renderer* ren) {
+        if (tex[i]) { SDL_DestroyTexture(tex[i]); SDL_DestroyTexture(texSel[i]); }
+        tex[i]=renderText(text, font, {255,255,255}, ren);
+        texSel[i]=renderText(text, font, {255,0,0}, ren);
         SDL_QueryTexture(tex[i], nullptr,nullptr, &dst[i].w,&dst[i].h);
-        dst[i].x=(SCREEN_WIDTH-dst[i].w)/2; dst[i].y=300+i*60;
+        dst[i].x=(SCREEN_WIDTH-dst[i].w)/2; dst[i].y=260+i*54;
     }
+    void Free() {
+        for (int i=0;i<n;++i) { SDL_DestroyTexture(tex[i]); SDL_DestroyTexture(texSel[i]); tex[i] = texSel[i] = nullptr; }
+        n = 0;
+    }
+    // up/down, true when the key was one of them
+    bool Navigate(SDL_Keycode key) {
+        if (key==SDLK_UP||key==SDLK_w) { sel=(sel-1+n)%n; return true; }
+        if (key==SDLK_DOWN||key==SDLK_s) { sel=(sel+1)%n; return true; }
+        return false;
+    }
+    void Draw(SDL_Renderer* ren) const {
+        for (int i=0;i<n;++i) SDL_RenderCopy(ren, i==sel ? texSel[i] : tex[i], nullptr, &dst[i]);
+    }
+};
 
-    while (true) {
-        while (SDL_PollEvent(&e)) {
-            if (e.type==SDL_QUIT) {
-                for (auto t:tex) SDL_DestroyTexture(t);
-                return MENU_QUIT;
+bool IsEnter(SDL_Keycode key) { return key==SDLK_RETURN||key==SDLK_KP_ENTER; }
+
+// Overlays darken the frozen scene under them.
+void DimScreen(SDL_Renderer* ren) {
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 170);
+    SDL_RenderFillRect(ren, nullptr);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
+// Red marker on a cell, drawn over the board.
+void DrawWarningCell(SDL_Renderer* ren, const Point& p) {
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_BLEND);
+    SDL_SetRenderDrawColor(ren, 255, 40, 40, 150);
+    SDL_Rect r{p.x, p.y, RECT_SIZE, RECT_SIZE};
+    SDL_RenderFillRect(ren, &r);
+    SDL_SetRenderDrawBlendMode(ren, SDL_BLENDMODE_NONE);
+}
+
+class MenuScene : public Scene {
+public:
+    MenuScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font) : ren(ren), win(win), font(font) {
+        Build();
+        MusicPlay(gMenuMusic, MUSIC_FADE_MS);
+    }
+    ~MenuScene() { list.Free(); }
+    const char* Name() const { return "menu"; }
+    // a game may have been left to resume
+    void Resume() {
+        list.Free();
+        Build();
+        MusicPlay(gMenuMusic, MUSIC_FADE_MS);
+    }
+
+    void HandleEvent(const SDL_Event& e) {
+        if (e.type!=SDL_KEYDOWN) return;
+        SDL_Keycode key = e.key.keysym.sym;
+        if (list.Navigate(key)) return;
+        if (ids[list.sel]==MENU_VERSUS && !IsEnter(key)) {
+            // left/right picks the layout, enter starts
+            if (key==SDLK_LEFT||key==SDLK_a||key==SDLK_RIGHT||key==SDLK_d) {
+                gVersusShared = !gVersusShared;
+                list.Set(list.sel, VersusLabel(), font, ren);
             }
-            if (e.type==SDL_KEYDOWN) {
-                if (e.key.keysym.sym==SDLK_UP||e.key.keysym.sym==SDLK_w) sel=(sel-1+opts.size())%opts.size();
-                if (e.key.keysym.sym==SDLK_DOWN||e.key.keysym.sym==SDLK_s) sel=(sel+1)%opts.size();
-                if (e.key.keysym.sym==SDLK_RETURN||e.key.keysym.sym==SDLK_KP_ENTER) {
-                    for (auto t:tex) SDL_DestroyTexture(t);
-                    if (canResume && sel == opts.size() - 2) {
-                        return MENU_RESUME;
-                    } else {
-                        return sel + 1;
-                    }
-                }
+            return;
+        }
+        if (ids[list.sel]==MENU_LEVEL||ids[list.sel]==MENU_BOARD) {
+            // left/right (or enter) walks through the choices
+            int step = 0;
+            if (key==SDLK_LEFT||key==SDLK_a) step = -1;
+            if (key==SDLK_RIGHT||key==SDLK_d||IsEnter(key)) step = 1;
+            if (step && ids[list.sel]==MENU_LEVEL) {
+                // -1 is the open board
+                gLevel = (gLevel + 1 + step + LevelCount() + 1) % (LevelCount() + 1) - 1;
+                list.Set(list.sel, LevelLabel(), font, ren);
+            }
+            if (step && ids[list.sel]==MENU_BOARD) {
+                gBoard = (gBoard + step + BOARD_COUNT) % BOARD_COUNT;
+                list.Set(list.sel, BoardLabel(), font, ren);
             }
+            return;
         }
+        if (!IsEnter(key)) return;
+        int id = ids[list.sel];
+        if (id==MENU_QUIT) SceneQuit();
+        else if (id==MENU_RESUME) ScenePush(MakeGameScene(ren, win, font, savedMode, true));
+        else if (id==MENU_VERSUS) ScenePush(MakeVersusScene(ren, win, font));
+        else ScenePush(MakeGameScene(ren, win, font, id, false));
+    }
 
+    void Render(SDL_Renderer* ren) {
         SDL_SetRenderDrawColor(ren,0,0,0,255); SDL_RenderClear(ren);
-        for (size_t i=0;i<opts.size();++i) {
-            SDL_Color c=(i==sel?SDL_Color{255,0,0}:SDL_Color{255,255,255});
-            SDL_DestroyTexture(tex[i]);
-            tex[i]=renderText(opts[i].c_str(), font, c, ren);
-            SDL_QueryTexture(tex[i], nullptr,nullptr, &dst[i].w,&dst[i].h);
-            dst[i].x=(SCREEN_WIDTH-dst[i].w)/2;
-            SDL_RenderCopy(ren, tex[i], nullptr, &dst[i]);
+        list.Draw(ren);
+    }
+
+private:
+    const char* LevelLabel() {
+        Level l;
+        snprintf(levelLabel, sizeof(levelLabel), "< Level: %s >", LevelGet(gLevel, l) ? l.name : "Open Field");
+        return levelLabel;
+    }
+    const char* VersusLabel() const {
+        return gVersusShared ? "< Versus: Shared Board >" : "< Versus: Split Screen >";
+    }
+    const char* BoardLabel() {
+        // levels are drawn for the native board only
+        snprintf(boardLabel, sizeof(boardLabel), "< Board: %s%s >", BOARD_NAMES[gBoard],
+                 gBoard != NATIVE_BOARD && gLevel >= 0 ? ", no level" : "");
+        return boardLabel;
+    }
+    void Build() {
+        const char* opts[10] = {"Classic Mode","Two-Layer Mode","Feast Mode","Power-Up Mode",VersusLabel()};
+        int n = 5;
+        ids[0] = MENU_CLASSIC; ids[1] = MENU_TWOLAYER; ids[2] = MENU_FEAST; ids[3] = MENU_POWERUP; ids[4] = MENU_VERSUS;
+        if (LevelCount() > 0) {
+            ids[n] = MENU_LEVEL;
+            opts[n++] = LevelLabel();
         }
-        SDL_RenderPresent(ren);
-        SDL_Delay(16);
+        ids[n] = MENU_BOARD;
+        opts[n++] = BoardLabel();
+        if (!gSaved.snake.empty()) {
+            ids[n] = MENU_RESUME;
+            opts[n++] = "Resume Game";
+        }
+        ids[n] = MENU_QUIT;
+        opts[n++] = "Quit";
+        for (int i=0;i<n;++i) list.Set(i, opts[i], font, ren);
+        list.n = n;
+        list.sel = SDL_min(list.sel, n-1);
     }
 
+    SDL_Renderer* ren;
+    SDL_Window* win;
+    TTF_Font* font;
+    MenuList list;
+    int ids[10];
+    char levelLabel[64];
+    char boardLabel[64];
+};
+
+Scene* MakeMenuScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font) {
+    return new MenuScene(ren, win, font);
 }
-int ShowPauseMenu(SDL_Renderer* ren, TTF_Font* font) {
-    vector<string> opts = {"Resume", "Quit Game"};
 
-    int sel = 0;
-    SDL_Event e;
-    vector<SDL_Texture*> tex(opts.size());
-    vector<SDL_Rect> dst(opts.size());
+class PauseScene : public Scene {
+public:
+    PauseScene(SDL_Renderer* ren, TTF_Font* font) {
+        list.Set(0, "Resume", font, ren);
+        list.Set(1, "Quit Game", font, ren);
+        list.n = 2;
+    }
+    ~PauseScene() { list.Free(); }
+    const char* Name() const { return "pause"; }
+    bool Overlay() const { return true; }
 
-    for (size_t i = 0; i < opts.size(); ++i) {
-        tex[i] = renderText(opts[i].c_str(), font, {255, 255, 255}, ren);
-        SDL_QueryTexture(tex[i], nullptr, nullptr, &dst[i].w, &dst[i].h);
-        dst[i].x = (SCREEN_WIDTH - dst[i].w) / 2;
-        dst[i].y = 300 + i * 60;
+    void HandleEvent(const SDL_Event& e) {
+        if (e.type!=SDL_KEYDOWN) return;
+        SDL_Keycode key = e.key.keysym.sym;
+        if (list.Navigate(key)) return;
+        if (key==SDLK_ESCAPE || (IsEnter(key) && list.sel==0)) ScenePop();
+        else if (IsEnter(key)) ScenePop(2); // the game goes with it
     }
 
-    while (true) {
-        while (SDL_PollEvent(&e)) {
-            if (e.type == SDL_QUIT) {
-                for (auto t : tex) SDL_DestroyTexture(t);
-                return 2;
-            }
-            if (e.type == SDL_KEYDOWN) {
-                if (e.key.keysym.sym == SDLK_UP || e.key.keysym.sym == SDLK_w) sel = (sel - 1 + opts.size()) % opts.size();
-                if (e.key.keysym.sym == SDLK_DOWN || e.key.keysym.sym == SDLK_s) sel = (sel + 1) % opts.size();
-                if (e.key.keysym.sym == SDLK_RETURN || e.key.keysym.sym == SDLK_KP_ENTER) {
-                    for (auto t : tex) SDL_DestroyTexture(t);
-                    return sel;
-                }
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    for (auto t : tex) SDL_DestroyTexture(t);
-                    return 0;
-                }
-            }
+    void Render(SDL_Renderer* ren) {
+        DimScreen(ren);
+        list.Draw(ren);
+    }
+
+private:
+    MenuList list;
+};
+
+// Over the board once the death animation has played.
+class GameOverScene : public Scene {
+public:
+    GameOverScene(SDL_Renderer* ren, TTF_Font* font, const char* title, bool canRewind) : canRewind(canRewind) {
+        lines[0] = renderText(title, font, {255,0,0}, ren);
+        lines[1] = renderText(canRewind ? "Enter: menu   R: rewind" : "Enter: menu", font, {255,255,255}, ren);
+        for (int i=0;i<2;++i) {
+            SDL_QueryTexture(lines[i], nullptr, nullptr, &dst[i].w, &dst[i].h);
+            dst[i].x=(SCREEN_WIDTH-dst[i].w)/2; dst[i].y=330+i*60;
+        }
+    }
+    ~GameOverScene() { SDL_DestroyTexture(lines[0]); SDL_DestroyTexture(lines[1]); }
+    const char* Name() const { return "game over"; }
+    bool Overlay() const { return true; }
+
+    void HandleEvent(const SDL_Event& e) {
+        if (e.type!=SDL_KEYDOWN) return;
+        SDL_Keycode key = e.key.keysym.sym;
+        if (IsEnter(key)||key==SDLK_ESCAPE) ScenePop(2);
+        // back to the game, which rewinds while R stays down
+        else if (canRewind && key==SDLK_r) ScenePop();
+    }
+
+    void Render(SDL_Renderer* ren) {
+        DimScreen(ren);
+        for (int i=0;i<2;++i) SDL_RenderCopy(ren, lines[i], nullptr, &dst[i]);
+    }
+
+private:
+    bool canRewind;
+    SDL_Texture* lines[2];
+    SDL_Rect dst[2];
+};
+
+// Board layers, drawn either by SDL or into the soft raster framebuffer.
+void DrawCell(SDL_Renderer* ren, SDL_Texture* tex, int x, int y) {
+    if (gSoftRaster) { SoftRasterDraw(tex, x, y); return; }
+    SDL_Rect r{x,y,RECT_SIZE,RECT_SIZE}; SDL_RenderCopy(ren,tex,nullptr,&r);
+}
+
+void DrawBackground(SDL_Renderer* ren) {
+    if (gSoftRaster) SoftRasterDraw(gBackgroundTexture,0,0);
+    else SDL_RenderCopy(ren,gBackgroundTexture,nullptr,nullptr);
+}
+
+// Quad `i` of a geometry batch: one cell, texture columns u0..u1.
+void PutCellQuad(SDL_Vertex* v, int* idx, int i, const Point& cell, SDL_Color tint, float u0 = 0, float u1 = 1) {
+    float x0 = cell.x, y0 = cell.y, x1 = x0 + RECT_SIZE, y1 = y0 + RECT_SIZE;
+    SDL_Vertex* q = v + i*4;
+    q[0] = {{x0,y0},tint,{u0,0}}; q[1] = {{x1,y0},tint,{u1,0}};
+    q[2] = {{x1,y1},tint,{u1,1}}; q[3] = {{x0,y1},tint,{u0,1}};
+    int* k = idx + i*6;
+    k[0] = i*4; k[1] = i*4+1; k[2] = i*4+2; k[3] = i*4+2; k[4] = i*4+3; k[5] = i*4;
+}
+
+// Cells per SDL_RenderGeometry call: 104 bytes of vertices and indices each,
+// so a batch takes 104 KB of the frame arena however big the board is.
+const int CELL_BATCH = 1024;
+
+// Many cells with one texture in SDL_RenderGeometry calls of up to
+// CELL_BATCH cells. The vertices live in the frame arena; SDL copies them
+// when the call is queued, so every batch reuses the same space.
+void DrawCells(SDL_Renderer* ren, SDL_Texture* tex, const Point* cells, int n, SDL_Color tint = {255,255,255,255}) {
+    if (n <= 0) return;
+    if (gSoftRaster) {
+        for (int i=0;i<n;++i) SoftRasterDraw(tex,cells[i].x,cells[i].y);
+        return;
+    }
+    size_t top = FrameArenaUsed();
+    for (int first = 0; first < n; first += CELL_BATCH) {
+        int m = SDL_min(n - first, CELL_BATCH);
+        SDL_Vertex* v = FrameAllocArray<SDL_Vertex>(m*4);
+        int* idx = FrameAllocArray<int>(m*6);
+        if (!v || !idx) {
+            for (int i=first;i<n;++i) DrawCell(ren,tex,cells[i].x,cells[i].y);
+            break;
+        }
+        for (int i=0;i<m;++i) PutCellQuad(v, idx, i, cells[first+i], tint);
+        SDL_RenderGeometry(ren,tex,v,m*4,idx,m*6);
+        FrameRewind(top);
+    }
+    FrameRewind(top);
+}
+
+const SDL_Color WALL_COLOR = {90, 60, 40, 255};
+
+void DrawWalls(SDL_Renderer* ren, const SDL_Rect* rects, int n) {
+    if (n <= 0) return;
+    if (gSoftRaster) { SoftRasterFill(rects, n, WALL_COLOR); return; }
+    SDL_SetRenderDrawColor(ren, WALL_COLOR.r, WALL_COLOR.g, WALL_COLOR.b, WALL_COLOR.a);
+    SDL_RenderFillRects(ren, rects, n);
+}
+
+// The static layers (background, level walls) are composed once into a
+// target at the exact output size, so a frame starts with one unscaled copy.
+// Rebuilt when the output size or the level changes, or targets get lost.
+const unsigned char* gStaticWalls = nullptr;
+int gStaticW = 0, gStaticH = 0;
+bool gStaticValid = false;
+unsigned gStaticBuilds = 0; // bumped whenever the layer is composed again
+
+bool BuildStaticLayer(SDL_Renderer* ren, int w, int h, const vector<SDL_Rect>& walls) {
+    if (!SDL_RenderTargetSupported(ren)) return false;
+    if (gStaticLayer == nullptr || w != gStaticW || h != gStaticH) {
+        if (gStaticLayer) SDL_DestroyTexture(gStaticLayer);
+        gStaticLayer = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+        if (gStaticLayer == nullptr) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Static layer %dx%d failed: %s", w, h, SDL_GetError());
+            return false;
         }
+        SDL_SetTextureBlendMode(gStaticLayer, SDL_BLENDMODE_NONE);
+        gStaticW = w; gStaticH = h;
+    }
+    SDL_SetRenderTarget(ren, gStaticLayer);
+    SDL_RenderSetScale(ren, w / (float)SCREEN_WIDTH, h / (float)SCREEN_HEIGHT);
+    SDL_RenderCopy(ren, gBackgroundTexture, nullptr, nullptr);
+    DrawWalls(ren, walls.data(), (int)walls.size());
+    SDL_SetRenderTarget(ren, nullptr); // brings back the window's own scale
+    return true;
+}
+
+// GPU path: makes sure the cached layer matches the level and output size.
+bool PrepareStaticLayer(SDL_Renderer* ren, const GameState& s, const vector<SDL_Rect>& walls, int w, int h) {
+    if (gStaticWalls != s.walls) gStaticValid = false;
+    if (gStaticValid && w == gStaticW && h == gStaticH) return true;
+    if (!BuildStaticLayer(ren, w, h, walls)) return false;
+    gStaticWalls = s.walls;
+    gStaticValid = true;
+    ++gStaticBuilds;
+    return true;
+}
+
+void DrawStaticLayer(SDL_Renderer* ren, const GameState& s, const vector<SDL_Rect>& walls) {
+    if (gSoftRaster) {
+        if (gStaticValid && gStaticWalls == s.walls && SoftRasterRestore()) return;
+        DrawBackground(ren);
+        DrawWalls(ren, walls.data(), (int)walls.size());
+        SoftRasterSave();
+        gStaticWalls = s.walls;
+        gStaticValid = true;
+        ++gStaticBuilds;
+        return;
+    }
+    int w, h;
+    SDL_GetRendererOutputSize(ren, &w, &h);
+    if (PrepareStaticLayer(ren, s, walls, w, h)) {
+        SDL_RenderCopy(ren, gStaticLayer, nullptr, nullptr);
+        return;
+    }
+    // no render targets: draw the layers every frame like before
+    DrawBackground(ren);
+    DrawWalls(ren, walls.data(), (int)walls.size());
+}
+
+// Puts the static layer back under one board cell (rect in board coordinates).
+void RestoreStatic(SDL_Renderer* ren, const SDL_Rect& r) {
+    if (gSoftRaster) { SoftRasterRestore(&r); return; }
+    SDL_Rect src{r.x * gStaticW / SCREEN_WIDTH, r.y * gStaticH / SCREEN_HEIGHT,
+                 r.w * gStaticW / SCREEN_WIDTH, r.h * gStaticH / SCREEN_HEIGHT};
+    SDL_RenderCopy(ren, gStaticLayer, &src, &r);
+}
+
+// Board cells to repaint in incremental mode, collected over the ticks of a frame.
+struct DirtyCells {
+    vector<int> cells;
+    vector<unsigned char> marked;
+    int item = -1; // Feast item under the next head, see MarkBeforeTick
+    DirtyCells() : marked(BOARD_CELLS, 0) { cells.reserve(BOARD_CELLS); }
+    void Mark(const Point& p) {
+        if (p.x < 0 || p.x >= SCREEN_WIDTH || p.y < 0 || p.y >= SCREEN_HEIGHT) return;
+        int c = CellIndex(p);
+        if (!marked[c]) { marked[c] = 1; cells.push_back(c); }
+    }
+    bool Has(const Point& p) const { return marked[CellIndex(p)] != 0; }
+    void Clear() {
+        for (int c : cells) marked[c] = 0;
+        cells.clear();
+    }
+};
+
+void DrawModeItems(SDL_Renderer*, const GameState&, ClassicMode) {}
+
+// Fake food cell for --share, -1 when the mode has none a bot can use
+// (Feast items are not exported).
+template<class B, class Mode> int SharedFake(const GameState&, Mode) { return -1; }
+template<class B> int SharedFake(const GameState& s, TwoLayerMode) { return B::Index(s.fake); }
+
+void DrawModeItems(SDL_Renderer* ren, const GameState& s, TwoLayerMode) {
+    DrawCell(ren,(s.fakeIsFood ? gFoodTexture : gFakeTexture),s.fake.x,s.fake.y);
+}
+
+// One batch per kind of item.
+void DrawModeItems(SDL_Renderer* ren, const GameState& s, FeastMode) {
+    int n = (int)s.items.size();
+    Point* food = FrameAllocArray<Point>(n);
+    Point* fake = FrameAllocArray<Point>(n);
+    Point* bonus = FrameAllocArray<Point>(n);
+    if (!food || !fake || !bonus) return;
+    int nf = 0, nk = 0, nb = 0;
+    for (const FeastItem& it : s.items) {
+        if (it.kind == FEAST_BONUS) bonus[nb++] = it.p;
+        else if (it.kind == FEAST_FAKE && !it.passed) fake[nk++] = it.p;
+        else food[nf++] = it.p;
+    }
+    DrawCells(ren, gFoodTexture, food, nf);
+    DrawCells(ren, gFakeTexture, fake, nk);
+    DrawCells(ren, gFoodTexture, bonus, nb, SDL_Color{255,215,0,255});
+}
+
+// Power-ups are plain squares, one colour per kind.
+const SDL_Color POWER_COLORS[POWER_KINDS] = {{60,200,255,255}, {70,90,255,255}, {230,60,230,255}, {235,235,235,255}};
+
+void DrawModeItems(SDL_Renderer* ren, const GameState& s, PowerUpMode) {
+    for (const PowerItem& it : s.power) {
+        if (it.kind < 0) continue;
+        SDL_Rect r{it.p.x + 3, it.p.y + 3, RECT_SIZE - 6, RECT_SIZE - 6};
+        const SDL_Color& c = POWER_COLORS[it.kind];
+        if (gSoftRaster) { SoftRasterFill(&r, 1, c); continue; }
+        SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
+        SDL_RenderFillRect(ren, &r);
+    }
+}
+
+// Cells a tick may change besides head, tail and food: where the mode's
+// items are before and after it.
+void MarkBeforeTick(DirtyCells&, const GameState&, ClassicMode) {}
+void MarkAfterTick(DirtyCells&, const GameState&, ClassicMode) {}
+void MarkBeforeTick(DirtyCells& d, const GameState& s, TwoLayerMode) { d.Mark(s.fake); }
+void MarkAfterTick(DirtyCells& d, const GameState& s, TwoLayerMode) { d.Mark(s.fake); }
+// only the item the head runs into can change or move
+void MarkBeforeTick(DirtyCells& d, const GameState& s, FeastMode) {
+    Point next(s.snake.front().x + s.nextDir.x, s.snake.front().y + s.nextDir.y);
+    bool inside = next.x >= 0 && next.x < SCREEN_WIDTH && next.y >= 0 && next.y < SCREEN_HEIGHT;
+    d.item = inside ? s.cellItem[CellIndex(next)] : -1;
+}
+void MarkAfterTick(DirtyCells& d, const GameState& s, FeastMode) {
+    if (d.item >= 0) d.Mark(s.items[d.item].p);
+    d.item = -1;
+}
+// items come and go on timers; a shrink takes half the snake off at once
+void MarkBeforeTick(DirtyCells& d, const GameState& s, PowerUpMode) {
+    for (const PowerItem& it : s.power) if (it.kind >= 0) d.Mark(it.p);
+    Point next(s.snake.front().x + s.nextDir.x, s.snake.front().y + s.nextDir.y);
+    int i = PowerUpMode::ItemAt(s, next);
+    if (i >= 0 && s.power[i].kind == POWER_SHRINK) for (const Point& p : s.snake) d.Mark(p);
+}
+void MarkAfterTick(DirtyCells& d, const GameState& s, PowerUpMode) {
+    for (const PowerItem& it : s.power) if (it.kind >= 0) d.Mark(it.p);
+}
+
+// Mode items lying on dirty cells, returns how many were drawn.
+int DrawModeCells(SDL_Renderer*, const GameState&, const DirtyCells&, ClassicMode) { return 0; }
+
+int DrawModeCells(SDL_Renderer* ren, const GameState& s, const DirtyCells& d, TwoLayerMode) {
+    if (!d.Has(s.fake)) return 0;
+    DrawModeItems(ren, s, TwoLayerMode());
+    return 1;
+}
+
+int DrawModeCells(SDL_Renderer* ren, const GameState& s, const DirtyCells& d, PowerUpMode) {
+    int n = 0;
+    for (const PowerItem& it : s.power) n += it.kind >= 0 && d.Has(it.p);
+    if (n) DrawModeItems(ren, s, PowerUpMode()); // a handful of squares, all of them
+    return n;
+}
+
+int DrawModeCells(SDL_Renderer* ren, const GameState& s, const DirtyCells& d, FeastMode) {
+    int n = 0;
+    for (int c : d.cells) {
+        if (s.cellItem[c] < 0) continue;
+        const FeastItem& it = s.items[s.cellItem[c]];
+        if (it.kind == FEAST_BONUS) DrawCells(ren, gFoodTexture, &it.p, 1, SDL_Color{255,215,0,255});
+        else DrawCell(ren, it.kind == FEAST_FAKE && !it.passed ? gFakeTexture : gFoodTexture, it.p.x, it.p.y);
+        ++n;
+    }
+    return n;
+}
+
+// Food, mode items and snake, returns the pixels written.
+template<class Mode> int DrawBoardItems(SDL_Renderer* ren, const GameState& s) {
+    DrawCell(ren,gFoodTexture,s.food.x,s.food.y);
+    DrawModeItems(ren, s, Mode());
+    DrawCell(ren,gHeadTexture,s.snake[0].x,s.snake[0].y);
+    DrawCells(ren,gBodyTexture,s.snake.data()+1,(int)s.snake.size()-1);
+    return (Mode::Reserved() + (int)s.snake.size())*RECT_SIZE*RECT_SIZE;
+}
+
+// Full board, returns the pixels written.
+template<class Mode> int DrawBoard(SDL_Renderer* ren, const GameState& s, const vector<SDL_Rect>& walls) {
+    DrawStaticLayer(ren, s, walls);
+    return SCREEN_WIDTH*SCREEN_HEIGHT + DrawBoardItems<Mode>(ren, s);
+}
+
+// Boards other than the native one are drawn in board units, scaled into a
+// centred viewport. Until ResetBoardView everything drawn lands on the board.
+template<class B> void SetBoardView(SDL_Renderer* ren) {
+    float k = SDL_min(SCREEN_WIDTH / (float)B::width, SCREEN_HEIGHT / (float)B::height);
+    SDL_RenderSetScale(ren, k, k);
+    SDL_Rect vp{(int)((SCREEN_WIDTH - B::width*k) / 2 / k), (int)((SCREEN_HEIGHT - B::height*k) / 2 / k), B::width, B::height};
+    SDL_RenderSetViewport(ren, &vp);
+}
+
+void ResetBoardView(SDL_Renderer* ren) {
+    SDL_RenderSetViewport(ren, nullptr);
+    SDL_RenderSetScale(ren, 1, 1);
+}
+
+// Only the dirty cells: static layer back under them, then whatever lies on them.
+template<class Mode> int RepaintCells(SDL_Renderer* ren, const GameState& s, const DirtyCells& d) {
+    const int cols = SCREEN_WIDTH/RECT_SIZE;
+    for (int c : d.cells) RestoreStatic(ren, SDL_Rect{c%cols*RECT_SIZE, c/cols*RECT_SIZE, RECT_SIZE, RECT_SIZE});
+    int sprites = 0;
+    if (d.Has(s.food)) { DrawCell(ren,gFoodTexture,s.food.x,s.food.y); ++sprites; }
+    sprites += DrawModeCells(ren, s, d, Mode());
+    // a dirty cell can hold any segment (the tail stays put when the snake grows)
+    for (size_t i = 0; i < s.snake.size(); ++i) {
+        if (!d.Has(s.snake[i])) continue;
+        DrawCell(ren, i==0 ? gHeadTexture : gBodyTexture, s.snake[i].x, s.snake[i].y);
+        ++sprites;
+    }
+    return ((int)d.cells.size() + sprites)*RECT_SIZE*RECT_SIZE;
+}
 
-        SDL_SetRenderDrawColor(ren, 0, 0, 0, 255); SDL_RenderClear(ren);
-        for (size_t i = 0; i < opts.size(); ++i) {
-            SDL_Color c = (i == sel ? SDL_Color{255, 0, 0} : SDL_Color{255, 255, 255});
-            SDL_DestroyTexture(tex[i]);
-            tex[i] = renderText(opts[i].c_str(), font, c, ren);
-            SDL_QueryTexture(tex[i], nullptr, nullptr, &dst[i].w, &dst[i].h);
-            dst[i].x = (SCREEN_WIDTH - dst[i].w) / 2;
-            SDL_RenderCopy(ren, tex[i], nullptr, &dst[i]);
+// Incremental renderer: the board stays in a persistent layer (the board
+// target, or the soft raster frame) and only the dirty cells are repainted.
+// `valid` false asks for a full redraw. Returns the pixels written.
+template<class Mode> int DrawBoardIncremental(SDL_Renderer* ren, const GameState& s, const vector<SDL_Rect>& walls,
+                                              DirtyCells& d, bool& valid) {
+    bool full = !valid || (int)d.cells.size() > BOARD_CELLS/4;
+    int px;
+    if (gSoftRaster) {
+        if (!gStaticValid || gStaticWalls != s.walls) full = true;
+        if (full) {
+            px = DrawBoard<Mode>(ren, s, walls);
+            SoftRasterFlush(ren);
+        }
+        else {
+            px = RepaintCells<Mode>(ren, s, d);
+            const int cols = SCREEN_WIDTH/RECT_SIZE;
+            int n = (int)d.cells.size();
+            SDL_Rect* rects = FrameAllocArray<SDL_Rect>(n);
+            for (int i = 0; rects && i < n; ++i)
+                rects[i] = SDL_Rect{d.cells[i]%cols*RECT_SIZE, d.cells[i]/cols*RECT_SIZE, RECT_SIZE, RECT_SIZE};
+            if (rects) SoftRasterFlush(ren, rects, n);
+            else SoftRasterFlush(ren);
+        }
+    }
+    else {
+        int w, h, bw = 0, bh = 0;
+        SDL_GetRendererOutputSize(ren, &w, &h);
+        unsigned builds = gStaticBuilds;
+        if (!PrepareStaticLayer(ren, s, walls, w, h)) {
+            // no render targets: plain full redraw every frame
+            d.Clear();
+            valid = false;
+            return DrawBoard<Mode>(ren, s, walls);
+        }
+        if (builds != gStaticBuilds) full = true;
+        if (gBoardLayer) SDL_QueryTexture(gBoardLayer, nullptr, nullptr, &bw, &bh);
+        if (bw != w || bh != h) {
+            if (gBoardLayer) SDL_DestroyTexture(gBoardLayer);
+            gBoardLayer = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, w, h);
+            if (gBoardLayer == nullptr) {
+                d.Clear();
+                valid = false;
+                return DrawBoard<Mode>(ren, s, walls);
+            }
+            SDL_SetTextureBlendMode(gBoardLayer, SDL_BLENDMODE_NONE);
+            full = true;
         }
-        SDL_RenderPresent(ren);
-        SDL_Delay(16);
+        SDL_SetRenderTarget(ren, gBoardLayer);
+        SDL_RenderSetScale(ren, w / (float)SCREEN_WIDTH, h / (float)SCREEN_HEIGHT);
+        px = full ? DrawBoard<Mode>(ren, s, walls) : RepaintCells<Mode>(ren, s, d);
+        SDL_SetRenderTarget(ren, nullptr);
+        SDL_RenderCopy(ren, gBoardLayer, nullptr, nullptr);
     }
+    d.Clear();
+    valid = true;
+    return px;
+}
+
+// One tick, with the cells it may change marked for the incremental renderer.
+template<class Mode, class B> TickResult TickMarked(GameState& s, DirtyCells* d) {
+    if (!d) return Tick<Mode, B>(s);
+    d->Mark(s.snake.front());
+    d->Mark(s.snake.back());
+    d->Mark(s.food);
+    MarkBeforeTick(*d, s, Mode());
+    TickResult r = Tick<Mode, B>(s);
+    d->Mark(s.snake.front());
+    d->Mark(s.food);
+    MarkAfterTick(*d, s, Mode());
+    return r;
 }
 
-void CoreGame(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font, int mode, bool resuming) {
-    bool twoLayer = (mode==MENU_TWOLAYER);
-    savedTwoLayer = twoLayer;
+// Sprites of the board, loaded for each game.
+bool LoadGameTextures(SDL_Renderer* ren, SDL_Window* win, bool fake) {
     gHeadTexture=loadTexture("head.png",ren);
     gBodyTexture=loadTexture("body.png",ren);
     gFoodTexture=loadTexture("food.png",ren);
-    if (twoLayer) gFakeTexture=loadTexture("fake.png",ren);
-    if (!gHeadTexture||!gBodyTexture||!gFoodTexture||(twoLayer&&!gFakeTexture)) {
-        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,"Error","Missing textures",win); return;
+    if (fake) gFakeTexture=loadTexture("fake.png",ren);
+    if (!gHeadTexture||!gBodyTexture||!gFoodTexture||(fake&&!gFakeTexture)) {
+        SDL_ShowSimpleMessageBox(SDL_MESSAGEBOX_ERROR,"Error","Missing textures",win);
+        FreeGameTextures();
+        return false;
+    }
+    if (gSoftRaster) {
+        SoftRasterAdd(gHeadTexture,"head.png",RECT_SIZE,RECT_SIZE);
+        SoftRasterAdd(gBodyTexture,"body.png",RECT_SIZE,RECT_SIZE);
+        SoftRasterAdd(gFoodTexture,"food.png",RECT_SIZE,RECT_SIZE);
+        if (fake) SoftRasterAdd(gFakeTexture,"fake.png",RECT_SIZE,RECT_SIZE);
     }
-    vector<Point> &snake = resuming ? savedSnake : savedSnake = {};
-    Point &dir = resuming ? savedDir : savedDir = {RECT_SIZE, 0};
-    Point &nextDir = resuming ? savedNextDir : savedNextDir = {dir.x, dir.y};
-    Point &food = resuming ? savedFood : savedFood;
-    Point &fake = resuming ? savedFake : savedFake;
-    bool &fakeConsumed = resuming ? savedFakeConsumed : savedFakeConsumed = false;
-    int &score = resuming ? savedScore : savedScore = 0;
-    Uint32 &last = resuming ? savedLast : savedLast = SDL_GetTicks();
-    Uint32 &interval = resuming ? savedInterval : savedInterval = 150;
-    bool fakePassed = false;
-    bool fakeIsFood = false;
+    return true;
+}
 
-    if (!resuming) {
-        snake.emplace_back(SCREEN_WIDTH/2/RECT_SIZE*RECT_SIZE, SCREEN_HEIGHT/2/RECT_SIZE*RECT_SIZE);
+void FreeGameTextures() {
+    SDL_Texture** all[] = {&gHeadTexture, &gBodyTexture, &gFoodTexture, &gFakeTexture};
+    for (SDL_Texture** t : all) {
+        if (*t == nullptr) continue;
+        SoftRasterRemove(*t);
+        SDL_DestroyTexture(*t);
+        *t = nullptr;
     }
+}
 
+// The game, compiled once per mode policy and board size. The renderer
+// caches (static layer, incremental mode, soft raster) are made for the
+// native board, other sizes use the plain SDL path.
+template<class Mode, class B> class GameScene : public Scene {
+public:
+    GameScene(SDL_Renderer* ren, TTF_Font* font, bool resuming) : ren(ren), font(font), s(gSaved) {
+        if (!resuming) {
+            Level level;
+            NewGame<Mode, B>(s, LevelGet(gLevel, level) ? &level : nullptr);
+            if (gTurbo) s.interval = TurboInterval(s.score);
+        }
+        if (!B::native && gSoftRaster) {
+            gSoftRaster = false;
+            softRasterOff = true;
+        }
+        s.last = NowUs();
+        UpdateScore();
+        ParticlesClear();
+        if (Mode::CanRewind()) HistoryReset(gHistory, s, B::cells + 1);
+        // level walls as one batch of rects, built once per game
+        for (int c = 0; s.walls && c < BOARD_CELLS; ++c) {
+            if (LevelBit(s.walls, c)) wallRects.push_back(SDL_Rect{c%(SCREEN_WIDTH/RECT_SIZE)*RECT_SIZE, c/(SCREEN_WIDTH/RECT_SIZE)*RECT_SIZE, RECT_SIZE, RECT_SIZE});
+        }
+        if (gDeadEnd) {
+            FloodFillReset<B>(flood);
+            deadEndTexture = renderText("Dead end ahead!", font, SDL_Color{255,80,60,255}, ren);
+            SDL_QueryTexture(deadEndTexture, nullptr, nullptr, &deadEndRect.w, &deadEndRect.h);
+            deadEndRect.x = SCREEN_WIDTH - deadEndRect.w - 10;
+            deadEndRect.y = 10;
+            CheckDeadEnd();
+        }
+        lastFrame = ticksStart = foodSince = SDL_GetTicks();
+        TelemetryPush(TEL_GAME_START, 0, 0, Mode::Name());
+        MusicPlay(gGameMusic, MUSIC_FADE_MS);
+        Publish(SHARE_RUNNING);
+    }
 
-    auto place=[&](Point &p){ do{ p.x=(rand()%(SCREEN_WIDTH/RECT_SIZE))*RECT_SIZE;
-                                   p.y=(rand()%(SCREEN_HEIGHT/RECT_SIZE))*RECT_SIZE;
-                              }while(find(snake.begin(),snake.end(),p)!=snake.end() || (twoLayer && p == fake)); };
+    ~GameScene() {
+        TelemetryPush(TEL_GAME_END, s.score, (int)s.snake.size());
+        Publish(SHARE_NO_GAME);
+        if (gTurbo) {
+            double secs = (SDL_GetTicks() - ticksStart) / 1000.0;
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                           "turbo: %llu ticks in %.1f s (%.0f ticks/s), final interval %u us, length %u",
+                           (unsigned long long)totalTicks, secs, secs > 0 ? totalTicks / secs : 0.0, s.interval, (unsigned)s.snake.size());
+        }
+        if (framesDrawn) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                           "render (%s): %u frames, %.0f board pixels touched per frame, peak %d",
+                           gIncremental ? "incremental" : "full redraw", framesDrawn,
+                           (double)pixelsTouched / framesDrawn, peakPixels);
+        }
+        if (floodRuns) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                           "dead-end check: %u runs, %.0f ns per run, peak %d ns",
+                           floodRuns, (double)floodNs / floodRuns, floodPeakNs);
+        }
+        gSaved.snake.clear();
+        SDL_DestroyTexture(deadEndTexture);
+        SDL_DestroyTexture(scoreTexture);
+        FreeGameTextures();
+        if (softRasterOff) gSoftRaster = true;
+    }
 
-    auto placeFake = [&](Point &p){ do{ p.x=(rand()%(SCREEN_WIDTH/RECT_SIZE))*RECT_SIZE;
-                                   p.y=(rand()%(SCREEN_HEIGHT/RECT_SIZE))*RECT_SIZE;
-                              }while(find(snake.begin(),snake.end(),p)!=snake.end() || p == food); };
+    const char* Name() const { return "gameplay"; }
 
-    if (!resuming) {
-        place(food);
-        if(twoLayer) placeFake(fake);
+    // sleep until the next tick; while effects play or R is held, every frame
+    Sint32 IdleWait() const {
+        if (deathAt || rewinding || ParticlesAlive() > 0) return 0;
+        return (Sint32)(((Sint64)(s.last + TickInterval(s)) - (Sint64)NowUs()) / 1000);
     }
 
-    bool running=true;
-    SDL_Event e;
-    SDL_Color textColor = {255, 255, 255};
-    SDL_Texture* scoreTexture = nullptr;
-    SDL_Rect scoreRect;
-    auto updateScore = [&](int newScore) {
-        score = newScore;
-        string scoreText = "Score: " + to_string(score);
+    // back from the pause menu: no catch-up for the paused time
+    void Resume() {
+        MusicPlay(gGameMusic, MUSIC_FADE_MS);
+        s.last = NowUs();
+        lastFrame = SDL_GetTicks();
+        boardValid = false;
+    }
+
+    void HandleEvent(const SDL_Event& e) {
+        redraw = true;
+        if(e.type==SDL_RENDER_TARGETS_RESET||e.type==SDL_RENDER_DEVICE_RESET) gStaticValid = boardValid = false;
+        if(e.type!=SDL_KEYDOWN) return;
+        if (e.key.keysym.sym == SDLK_ESCAPE) {
+            ScenePush(new PauseScene(ren, font));
+            return;
+        }
+        if((e.key.keysym.sym==SDLK_UP||e.key.keysym.sym==SDLK_w)&&s.dir.y==0) s.nextDir = Point(0,-RECT_SIZE);
+        if((e.key.keysym.sym==SDLK_DOWN||e.key.keysym.sym==SDLK_s)&&s.dir.y==0) s.nextDir = Point(0,RECT_SIZE);
+        if((e.key.keysym.sym==SDLK_LEFT||e.key.keysym.sym==SDLK_a)&&s.dir.x==0) s.nextDir = Point(-RECT_SIZE,0);
+        if((e.key.keysym.sym==SDLK_RIGHT||e.key.keysym.sym==SDLK_d)&&s.dir.x==0) s.nextDir = Point(RECT_SIZE,0);
+        CheckDeadEnd(); // the warning follows the turn the player just asked for
+    }
+
+    void Update() {
+        Uint32 now = SDL_GetTicks();
+        bool animating = deathAt || ParticlesAlive() > 0;
+        float dt = animating ? SDL_min(now - lastFrame, 50u) / 1000.0f : 0;
+        lastFrame = now;
+        bool wasRewinding = rewinding;
+        rewinding = Mode::CanRewind() && SDL_GetKeyboardState(nullptr)[SDL_SCANCODE_R];
+        if (rewinding) Rewind(wasRewinding);
+        else if (deathAt) {
+            if (now - deathAt >= 900) {
+                ScenePush(new GameOverScene(ren, font, FramePrintf("Game Over - Score: %d", s.score), Mode::CanRewind()));
+                return;
+            }
+        }
+        else RunTicks(now);
+        ParticlesUpdate(dt);
+        if (animating) redraw = true;
+    }
+
+    void Render(SDL_Renderer* ren) {
+        // the static layer covers the whole output, no clear needed
+        int px;
+        if (!B::native) {
+            DrawStaticLayer(ren, s, wallRects);
+            SetBoardView<B>(ren);
+            DimScreen(ren); // shows where the board ends
+            px = SCREEN_WIDTH*SCREEN_HEIGHT + DrawBoardItems<Mode>(ren, s);
+            if (deadEnd) DrawWarningCell(ren, deadEndCell);
+            ParticlesRender(ren);
+            ResetBoardView(ren);
+        }
+        else {
+            if (incremental) px = DrawBoardIncremental<Mode>(ren, s, wallRects, dirtyCells, boardValid);
+            else {
+                px = DrawBoard<Mode>(ren, s, wallRects);
+                if (gSoftRaster) SoftRasterFlush(ren);
+            }
+            // the warning, particles and the score are overlays, never part of the board layer
+            if (deadEnd) DrawWarningCell(ren, deadEndCell);
+            ParticlesRender(ren);
+        }
+        pixelsTouched += px;
+        peakPixels = SDL_max(peakPixels, px);
+        ++framesDrawn;
+        SDL_RenderCopy(ren, scoreTexture, nullptr, &scoreRect);
+        if (deadEnd) SDL_RenderCopy(ren, deadEndTexture, nullptr, &deadEndRect);
+    }
+
+private:
+    void UpdateScore() {
         SDL_DestroyTexture(scoreTexture);
-        scoreTexture = renderText(scoreText.c_str(), font, textColor, ren);
+        scoreTexture = renderText(FramePrintf("Score: %d", s.score), font, SDL_Color{255,255,255,255}, ren);
         SDL_QueryTexture(scoreTexture, nullptr, nullptr, &scoreRect.w, &scoreRect.h);
         scoreRect.x = 10;
         scoreRect.y = 10;
-    };
-
-    updateScore(score);
-
-    while (running) {
-        while(SDL_PollEvent(&e)){
-            if(e.type==SDL_QUIT){running=false;break;}
-            if(e.type==SDL_KEYDOWN){
-                if (e.key.keysym.sym == SDLK_ESCAPE) {
-                    paused = true;
-                    int pauseResult = ShowPauseMenu(ren, font);
-                    if (pauseResult == 1) {
-                        savedSnake.clear();
-                        running = false;
-                        break;
-                    }
-                    else if (pauseResult == 2) {
-                        running = false;
-                        break;
-                    }
-                    else {
-                        paused = false;
-                        last = SDL_GetTicks();
-                    }
+    }
+
+    // hold R: play the history backwards at twice the tick rate, also out of a death
+    void Rewind(bool wasRewinding) {
+        Uint64 nowUs = NowUs(), step = SDL_max(s.interval / 2, 1u);
+        if (!wasRewinding) {
+            Uint64 span = REWIND_US / s.interval;
+            rewindFloor = gHistory.tick > span ? gHistory.tick - span : 0;
+            s.last = nowUs;
+        }
+        Uint64 back = 0;
+        if (nowUs - s.last > MAX_TICK_BACKLOG_US) s.last = nowUs - step;
+        while (nowUs - s.last >= step) { s.last += step; ++back; }
+        if (back && gHistory.tick > rewindFloor) {
+            int undone = HistoryRewindTo(gHistory, s, gHistory.tick - SDL_min(back, gHistory.tick - rewindFloor));
+            gameTick -= undone;
+            // alive again only once the state actually went back, a tap of R
+            // that undid nothing leaves the death as it was
+            if (undone) deathAt = 0;
+            Publish(SHARE_RUNNING);
+            CheckDeadEnd();
+            UpdateScore();
+            boardValid = false;
+            redraw = true;
+        }
+    }
+
+    // effects follow the snake from left to right
+    static float Pan(const Point& p) {
+        return (p.x + RECT_SIZE/2) * 2.0f / B::width - 1;
+    }
+
+    // --dead-end: can the snake fit in the free area behind the cell it moves
+    // to next? The fill gives up once it found room for the whole snake.
+    void CheckDeadEnd() {
+        if (!gDeadEnd) return;
+        Uint64 start = SDL_GetPerformanceCounter();
+        int len = (int)s.snake.size();
+        bool was = deadEnd;
+        deadEndCell = B::Next(s.snake.front(), s.nextDir);
+        deadEnd = ReachableArea<B>(flood, s, deadEndCell, len) < len;
+        int ns = (int)((SDL_GetPerformanceCounter() - start) * 1000000000 / SDL_GetPerformanceFrequency());
+        floodNs += ns;
+        floodPeakNs = SDL_max(floodPeakNs, ns);
+        ++floodRuns;
+        if (deadEnd != was) redraw = true;
+    }
+
+    // --share: the state after the latest tick, for bots and observers
+    void Publish(int status) {
+        ShareState* out = ShareBegin();
+        if (!out) return;
+        out->tick = gameTick;
+        out->status = status;
+        out->cols = B::cols;
+        out->rows = B::rows;
+        out->score = s.score;
+        out->dirX = s.dir.x / RECT_SIZE;
+        out->dirY = s.dir.y / RECT_SIZE;
+        out->food = B::Index(s.food);
+        out->fake = SharedFake<B>(s, Mode());
+        out->fakeIsFood = s.fakeIsFood;
+        out->len = (int)s.snake.size();
+        for (int i = 0; i < out->len; ++i) out->body[i] = (Uint16)B::Index(s.snake[i]);
+        ShareCommit();
+    }
+
+    // directions the bot queued, one per tick, with the same rule as the keys
+    void PollBot() {
+        static const Point dirs[4] = {Point(0,-RECT_SIZE), Point(RECT_SIZE,0), Point(0,RECT_SIZE), Point(-RECT_SIZE,0)};
+        int d;
+        if (!SharePollInput(d) || d < 0 || d > 3) return;
+        if (dirs[d].x ? s.dir.x == 0 : s.dir.y == 0) s.nextDir = dirs[d];
+    }
+
+    // fixed-step simulation: run every tick that is due, draw only the latest state
+    void RunTicks(Uint32 now) {
+        Uint64 tickStart = SDL_GetPerformanceCounter();
+        Uint64 nowUs = NowUs();
+        if (nowUs - s.last > MAX_TICK_BACKLOG_US) s.last = nowUs - TickInterval(s);
+        int ticks = 0, eaten = 0;
+        Point tail;
+        // effects can change the interval from one tick to the next
+        while (nowUs - s.last >= TickInterval(s)) {
+            s.last += TickInterval(s);
+            ++ticks;
+            if (ShareActive()) PollBot();
+            else if (gTurbo) s.nextDir = AutopilotDir<B>(s.snake.front());
+            tail = s.snake.back();
+            TickResult r = TickMarked<Mode, B>(s, incremental ? &dirtyCells : nullptr);
+            const Point &head = s.snake.front();
+            if (r == TICK_DIED) {
+                VoicePlay(gLoseSound, 1, Pan(head), 10);
+                Point next = B::Next(head, s.dir);
+                bool wall = !B::Inside(next) || OnWall<B>(s, next);
+                TelemetryPush(TEL_DEATH, s.score, 0, wall ? "wall" : "self");
+                ParticlesBurst(head.x + RECT_SIZE/2, head.y + RECT_SIZE/2, 600, 260, 0.9f, SDL_Color{255,80,40,255}, 300);
+                ParticlesBurst(head.x + RECT_SIZE/2, head.y + RECT_SIZE/2, 200, 140, 0.6f, SDL_Color{255,255,255,255});
+                deathAt = now;
+                Publish(SHARE_DEAD);
+                break;
+            }
+            ++gameTick;
+            Publish(SHARE_RUNNING);
+            CheckDeadEnd();
+            if (Mode::CanRewind()) HistoryRecord(gHistory, s);
+            if (r == TICK_ATE) {
+                TelemetryPush(TEL_FOOD, s.score, now - foodSince);
+                foodSince = now;
+                // at turbo speed many foods go per frame, keep the effects bounded
+                if (++eaten <= 8) {
+                    ParticlesBurst(head.x + RECT_SIZE/2, head.y + RECT_SIZE/2, 80, 160, 0.5f, SDL_Color{255,220,60,255});
+                    VoicePlay(gEatSound, 1, Pan(head));
                 }
-                if((e.key.keysym.sym==SDLK_UP||e.key.keysym.sym==SDLK_w)&&dir.y==0) nextDir = Point(0,-RECT_SIZE);
-                if((e.key.keysym.sym==SDLK_DOWN||e.key.keysym.sym==SDLK_s)&&dir.y==0) nextDir = Point(0,RECT_SIZE);
-                if((e.key.keysym.sym==SDLK_LEFT||e.key.keysym.sym==SDLK_a)&&dir.x==0) nextDir = Point(-RECT_SIZE,0);
-                if((e.key.keysym.sym==SDLK_RIGHT||e.key.keysym.sym==SDLK_d)&&dir.x==0) nextDir = Point(RECT_SIZE,0);
+                if (gTurbo) s.interval = TurboInterval(s.score);
             }
+            // the board is full, nowhere left to put food
+            if (BoardFull<Mode, B>(s)) { deathAt = now; break; }
         }
-         if (!paused) {
-            Uint32 now = SDL_GetTicks();
-            if (now - last >= interval) {
-                last = now;
-                dir = Point(nextDir.x, nextDir.y);
-
-                Point head(snake.front().x + dir.x, snake.front().y + dir.y);
-                // boundary check
-                if (head.x < 0 || head.x >= SCREEN_WIDTH || head.y < 0 || head.y >= SCREEN_HEIGHT) {
-                    Mix_PlayChannel(-1, gLoseSound, 0);
-                    running = false;
-                    break;
-                }
-                if (find(snake.begin(), snake.end(), head) != snake.end()) {
-                    Mix_PlayChannel(-1, gLoseSound, 0);
-                    running = false;
-                    break;
+        if (ticks == 0) return;
+        PerfTicks(ticks, TelemetryUsSince(tickStart));
+        ScriptSnakeLength((int)s.snake.size());
+        redraw = true;
+        totalTicks += ticks;
+        if (eaten) UpdateScore();
+        else if (!deathAt && !(s.snake.back() == tail)) {
+            ParticlesBurst(tail.x + RECT_SIZE/2, tail.y + RECT_SIZE/2, 6, 25, 0.4f, SDL_Color{120,255,120,160});
+        }
+    }
+
+    SDL_Renderer* ren;
+    TTF_Font* font;
+    GameState& s;
+    SDL_Texture* scoreTexture = nullptr;
+    SDL_Rect scoreRect;
+    vector<SDL_Rect> wallRects;
+    Uint32 lastFrame = 0;
+    Uint32 deathAt = 0; // let the death explosion play before leaving
+    Uint32 ticksStart = 0;
+    Uint32 foodSince = 0; // for time-to-eat
+    Uint64 totalTicks = 0;
+    Uint64 gameTick = 0; // ticks of the current timeline, goes back on rewind
+    FloodFill flood;
+    bool deadEnd = false;
+    Point deadEndCell;
+    SDL_Texture* deadEndTexture = nullptr;
+    SDL_Rect deadEndRect;
+    Uint64 floodNs = 0;
+    Uint32 floodRuns = 0;
+    int floodPeakNs = 0;
+    unsigned long long rewindFloor = 0; // oldest tick this hold of R may reach
+    bool rewinding = false;
+    bool softRasterOff = false; // turned off for this board, back on when it ends
+    const bool incremental = gIncremental && B::native;
+    DirtyCells dirtyCells;
+    bool boardValid = false; // incremental renderer: false forces a full redraw
+    Uint64 pixelsTouched = 0;
+    Uint32 framesDrawn = 0;
+    int peakPixels = 0;
+};
+
+template<class B> Scene* MakeGameSceneOn(SDL_Renderer* ren, TTF_Font* font, int mode, bool resuming) {
+    switch (mode) {
+    case MENU_TWOLAYER: return new GameScene<TwoLayerMode, B>(ren, font, resuming);
+    case MENU_FEAST:    return new GameScene<FeastMode, B>(ren, font, resuming);
+    case MENU_POWERUP:  return new GameScene<PowerUpMode, B>(ren, font, resuming);
+    default:            return new GameScene<ClassicMode, B>(ren, font, resuming);
+    }
+}
+
+// Single runtime dispatch: pick mode and board once, then stay in their instantiation.
+Scene* MakeGameScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font, int mode, bool resuming) {
+    savedMode = mode;
+    if (!resuming) savedBoard = gBoard;
+    if (!LoadGameTextures(ren, win, mode==MENU_TWOLAYER || mode==MENU_FEAST)) return nullptr; // both draw fake food
+    switch (savedBoard) {
+    case 0:  return MakeGameSceneOn<Board<20,20> >(ren, font, mode, resuming);
+    case 2:  return MakeGameSceneOn<Board<64,64> >(ren, font, mode, resuming);
+    case 3:  return MakeGameSceneOn<Board<128,128> >(ren, font, mode, resuming);
+    default: return MakeGameSceneOn<ScreenBoard>(ren, font, mode, resuming);
+    }
+}
+
+// Versus split screen: one viewport per player, side by side. Each frame
+// the background goes out once for the whole window, then every viewport
+// culls the board to the cells it shows and sends them as one geometry
+// batch from the sprite atlas, so the cost per viewport is one call however
+// long the snakes get.
+const int VERSUS_VIEW_W = SCREEN_WIDTH / VERSUS_PLAYERS;
+const SDL_Color VERSUS_TINT[VERSUS_PLAYERS] = {{255,255,255,255}, {110,160,255,255}}; // bodies
+const SDL_Color NO_TINT = {255,255,255,255};
+const Uint64 VERSUS_BUDGET_US = 1000000 / 144; // frame time the renderer has to stay under
+enum { ATLAS_HEAD, ATLAS_BODY, ATLAS_FOOD, ATLAS_SLOTS };
+
+// Head, body and food side by side in one target texture. nullptr without
+// render targets, the viewports then use one batch per sprite instead.
+SDL_Texture* BuildSpriteAtlas(SDL_Renderer* ren, SDL_Texture* atlas) {
+    if (!SDL_RenderTargetSupported(ren)) return nullptr;
+    if (atlas == nullptr) atlas = SDL_CreateTexture(ren, SDL_PIXELFORMAT_ARGB8888, SDL_TEXTUREACCESS_TARGET, ATLAS_SLOTS*RECT_SIZE, RECT_SIZE);
+    if (atlas == nullptr) {
+        SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_ERROR, "Sprite atlas failed: %s", SDL_GetError());
+        return nullptr;
+    }
+    SDL_Texture* sprites[ATLAS_SLOTS] = {gHeadTexture, gBodyTexture, gFoodTexture};
+    SDL_SetRenderTarget(ren, atlas);
+    SDL_SetRenderDrawColor(ren, 0, 0, 0, 0);
+    SDL_RenderClear(ren);
+    for (int i = 0; i < ATLAS_SLOTS; ++i) {
+        // copied as they are, alpha included
+        SDL_BlendMode mode;
+        SDL_GetTextureBlendMode(sprites[i], &mode);
+        SDL_SetTextureBlendMode(sprites[i], SDL_BLENDMODE_NONE);
+        SDL_Rect r{i*RECT_SIZE, 0, RECT_SIZE, RECT_SIZE};
+        SDL_RenderCopy(ren, sprites[i], nullptr, &r);
+        SDL_SetTextureBlendMode(sprites[i], mode);
+    }
+    SDL_SetRenderTarget(ren, nullptr);
+    SDL_SetTextureBlendMode(atlas, SDL_BLENDMODE_BLEND);
+    return atlas;
+}
+
+// Cells of one sprite and tint inside a viewport, in view coordinates.
+struct SpriteRun {
+    SDL_Texture* tex;
+    int slot; // in the atlas
+    SDL_Color tint;
+    const Point* cells;
+    int n;
+};
+
+// The cells in the board columns [camX, camX + VERSUS_VIEW_W), moved into
+// view coordinates. Returns how many there were.
+int CullCells(const Point* cells, int n, int camX, Point* out) {
+    int k = 0;
+    for (int i = 0; i < n; ++i)
+        if (cells[i].x >= camX && cells[i].x < camX + VERSUS_VIEW_W) out[k++] = Point(cells[i].x - camX, cells[i].y);
+    return k;
+}
+
+void FillRect(SDL_Renderer* ren, const SDL_Rect& r, SDL_Color c) {
+    if (gSoftRaster) { SoftRasterFill(&r, 1, c); return; }
+    SDL_SetRenderDrawColor(ren, c.r, c.g, c.b, c.a);
+    SDL_RenderFillRect(ren, &r);
+}
+
+// Player one on WASD, player two on the arrow keys. Compiled once per rule
+// set, with its board: one board each (split) or one wider than the window
+// that both viewports scroll over (shared).
+template<class Rules, class B> class VersusScene : public Scene {
+public:
+    VersusScene(SDL_Renderer* ren, TTF_Font* font) : ren(ren), font(font) {
+        Rules::template Start<B>(v);
+        interval = gTurbo ? TurboInterval(0) : v.p[0].interval;
+        last = NowUs();
+        lastFrame = SDL_GetTicks();
+        atlas = BuildSpriteAtlas(ren, nullptr);
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) UpdateScore(i);
+        ParticlesClear();
+        TelemetryPush(TEL_GAME_START, 0, 0, Rules::Name());
+        MusicPlay(gGameMusic, MUSIC_FADE_MS);
+    }
+
+    ~VersusScene() {
+        TelemetryPush(TEL_GAME_END, v.p[0].score, v.p[1].score);
+        if (framesDrawn) {
+            SDL_LogMessage(SDL_LOG_CATEGORY_APPLICATION, SDL_LOG_PRIORITY_INFO,
+                           "render (%s): %u frames, %.0f us per frame, peak %d us, budget %d us (144 Hz)",
+                           Rules::Name(), framesDrawn, (double)renderUs / framesDrawn, peakUs, (int)VERSUS_BUDGET_US);
+        }
+        for (SDL_Texture* t : scoreTexture) SDL_DestroyTexture(t);
+        if (atlas) SDL_DestroyTexture(atlas);
+        FreeGameTextures();
+    }
+
+    const char* Name() const { return "versus"; }
+
+    Sint32 IdleWait() const {
+        if (deathAt || ParticlesAlive() > 0) return 0;
+        return (Sint32)(((Sint64)(last + interval) - (Sint64)NowUs()) / 1000);
+    }
+
+    void Resume() {
+        MusicPlay(gGameMusic, MUSIC_FADE_MS);
+        last = NowUs();
+        lastFrame = SDL_GetTicks();
+    }
+
+    void HandleEvent(const SDL_Event& e) {
+        redraw = true;
+        if (e.type==SDL_RENDER_TARGETS_RESET||e.type==SDL_RENDER_DEVICE_RESET) {
+            gStaticValid = false;
+            if (atlas) atlas = BuildSpriteAtlas(ren, atlas);
+        }
+        if (e.type!=SDL_KEYDOWN) return;
+        SDL_Keycode key = e.key.keysym.sym;
+        if (key == SDLK_ESCAPE) {
+            ScenePush(new PauseScene(ren, font));
+            return;
+        }
+        Steer(v.p[0], key, SDLK_w, SDLK_s, SDLK_a, SDLK_d);
+        Steer(v.p[1], key, SDLK_UP, SDLK_DOWN, SDLK_LEFT, SDLK_RIGHT);
+    }
+
+    void Update() {
+        Uint32 now = SDL_GetTicks();
+        bool animating = deathAt || ParticlesAlive() > 0;
+        float dt = animating ? SDL_min(now - lastFrame, 50u) / 1000.0f : 0;
+        lastFrame = now;
+        if (deathAt) {
+            if (now - deathAt >= 900) {
+                ScenePush(new GameOverScene(ren, font, Result(), false));
+                return;
+            }
+        }
+        else RunTicks(now);
+        ParticlesUpdate(dt);
+        if (animating) redraw = true;
+    }
+
+    void Render(SDL_Renderer* ren) {
+        Uint64 start = SDL_GetPerformanceCounter();
+        DrawStaticLayer(ren, v.p[0], noWalls); // one background for both viewports
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) DrawView(ren, i);
+        FillRect(ren, SDL_Rect{VERSUS_VIEW_W - 2, 0, 4, SCREEN_HEIGHT}, SDL_Color{20,20,20,255});
+        if (gSoftRaster) SoftRasterFlush(ren);
+        ParticlesRender(ren);
+        for (int i = 0; i < VERSUS_PLAYERS; ++i) SDL_RenderCopy(ren, scoreTexture[i], nullptr, &scoreRect[i]);
+        int us = (int)TelemetryUsSince(start);
+        renderUs += us;
+        peakUs = SDL_max(peakUs, us);
+        ++framesDrawn;
+    }
+
+private:
+    // same rule as the single player game: no turning back on the spot
+    static void Steer(GameState& s, SDL_Keycode key, SDL_Keycode up, SDL_Keycode down, SDL_Keycode left, SDL_Keycode right) {
+        if (key==up&&s.dir.y==0) s.nextDir = Point(0,-RECT_SIZE);
+        if (key==down&&s.dir.y==0) s.nextDir = Point(0,RECT_SIZE);
+        if (key==left&&s.dir.x==0) s.nextDir = Point(-RECT_SIZE,0);
+        if (key==right&&s.dir.x==0) s.nextDir = Point(RECT_SIZE,0);
+    }
+
+    // Board column at the left edge of viewport i, whole cells: the shared
+    // board scrolls with the player's head, stopping at the board edges.
+    int Camera(int i) const {
+        if (!Rules::Shared()) return 0;
+        int x = v.p[i].snake.front().x - (VERSUS_VIEW_W - RECT_SIZE) / 2 / RECT_SIZE * RECT_SIZE;
+        return SDL_max(0, SDL_min(x, B::width - VERSUS_VIEW_W));
+    }
+
+    SpriteRun& AddRun(SpriteRun* runs, int& n, SDL_Texture* tex, int slot, SDL_Color tint) {
+        SpriteRun& r = runs[n++];
+        r.tex = tex; r.slot = slot; r.tint = tint; r.n = 0;
+        return r;
+    }
+
+    // Viewport i: the cells it shows, culled and moved into view coordinates,
+    // then one batch. The soft raster ignores viewports, its cells are
+    // offset by hand (culling keeps them inside) and, having no colour mod,
+    // it fills the tinted bodies as plain squares.
+    void DrawView(SDL_Renderer* ren, int i) {
+        const SDL_Rect vp{i*VERSUS_VIEW_W, 0, VERSUS_VIEW_W, SCREEN_HEIGHT};
+        int camX = Camera(i);
+        int total = 1;
+        for (const GameState& s : v.p) total += (int)s.snake.size();
+        Point* cells = FrameAllocArray<Point>(total);
+        if (!cells) return;
+        SpriteRun runs[1 + 2*VERSUS_PLAYERS];
+        int nr = 0, used = 0;
+        const GameState& own = v.p[Rules::Shared() ? 0 : i];
+        SpriteRun& food = AddRun(runs, nr, gFoodTexture, ATLAS_FOOD, NO_TINT);
+        food.cells = cells + used;
+        used += food.n = CullCells(&own.food, 1, camX, cells + used);
+        for (int p = 0; p < VERSUS_PLAYERS; ++p) {
+            if (!Rules::Shared() && p != i) continue; // the other board is not in this view
+            const GameState& s = v.p[p];
+            SpriteRun& head = AddRun(runs, nr, gHeadTexture, ATLAS_HEAD, NO_TINT);
+            head.cells = cells + used;
+            used += head.n = CullCells(s.snake.data(), 1, camX, cells + used);
+            SpriteRun& body = AddRun(runs, nr, gBodyTexture, ATLAS_BODY, VERSUS_TINT[p]);
+            body.cells = cells + used;
+            used += body.n = CullCells(s.snake.data() + 1, (int)s.snake.size() - 1, camX, cells + used);
+        }
+        if (gSoftRaster) {
+            for (int r = 0; r < nr; ++r) {
+                const SpriteRun& run = runs[r];
+                bool tinted = run.tint.r != 255 || run.tint.g != 255 || run.tint.b != 255;
+                for (int c = 0; c < run.n; ++c) {
+                    const Point& p = run.cells[c];
+                    if (tinted) FillRect(ren, SDL_Rect{vp.x + p.x + 2, p.y + 2, RECT_SIZE - 4, RECT_SIZE - 4}, run.tint);
+                    else SoftRasterDraw(run.tex, vp.x + p.x, p.y);
                 }
-                snake.insert(snake.begin(), head);
-                if (head == food) {
-                    place(food);
-                    updateScore(score + 10);
-                    Mix_PlayChannel(-1, gEatSound, 0);
+            }
+        }
+        else {
+            SDL_RenderSetViewport(ren, &vp);
+            SDL_Vertex* vtx = atlas ? FrameAllocArray<SDL_Vertex>(used*4) : nullptr;
+            int* idx = atlas ? FrameAllocArray<int>(used*6) : nullptr;
+            if (vtx && idx) {
+                int q = 0;
+                for (int r = 0; r < nr; ++r) {
+                    float u0 = runs[r].slot / (float)ATLAS_SLOTS, u1 = (runs[r].slot + 1) / (float)ATLAS_SLOTS;
+                    for (int c = 0; c < runs[r].n; ++c) PutCellQuad(vtx, idx, q++, runs[r].cells[c], runs[r].tint, u0, u1);
                 }
-                else if (twoLayer) {
-                    if (head == fake && !fakePassed) {
-                        fakePassed = true;
-                        fakeIsFood = true;
-                    }
-                    else if (head == fake && fakePassed) {
-                        placeFake(fake);
-                        fakePassed = false;
-                        fakeIsFood = false;
-                        updateScore(score + 20);
-                        Mix_PlayChannel(-1, gEatSound, 0);
-                        placeFake(fake);
-
-                    }
-                    else {
-                        snake.pop_back();
-                    }
+                if (q) SDL_RenderGeometry(ren, atlas, vtx, q*4, idx, q*6);
+            }
+            else for (int r = 0; r < nr; ++r) DrawCells(ren, runs[r].tex, runs[r].cells, runs[r].n, runs[r].tint);
+            SDL_RenderSetViewport(ren, nullptr);
+        }
+        if (Rules::Shared()) {
+            // where the view is on the board
+            const int barW = VERSUS_VIEW_W - 20;
+            FillRect(ren, SDL_Rect{vp.x + 10, SCREEN_HEIGHT - 10, barW, 4}, SDL_Color{60,60,60,255});
+            FillRect(ren, SDL_Rect{vp.x + 10 + camX * barW / B::width, SCREEN_HEIGHT - 10, VERSUS_VIEW_W * barW / B::width, 4},
+                     SDL_Color{220,220,220,255});
+        }
+    }
+
+    void UpdateScore(int i) {
+        SDL_DestroyTexture(scoreTexture[i]);
+        scoreTexture[i] = renderText(FramePrintf("P%d: %d", i + 1, v.p[i].score), font, SDL_Color{255,255,255,255}, ren);
+        SDL_QueryTexture(scoreTexture[i], nullptr, nullptr, &scoreRect[i].w, &scoreRect[i].h);
+        scoreRect[i].x = i*VERSUS_VIEW_W + 10;
+        scoreRect[i].y = 10;
+    }
+
+    // Effects go where the player sees its own head.
+    void Burst(int i, const Point& p, int count, float speed, float life, SDL_Color color, float gravity = 0) {
+        float x = i*VERSUS_VIEW_W + p.x - Camera(i) + RECT_SIZE/2, y = p.y + RECT_SIZE/2;
+        ParticlesBurst(x, y, count, speed, life, color, gravity);
+    }
+
+    // Whoever is left wins; both out or the board full, the score decides.
+    const char* Result() const {
+        int a = v.p[0].score, b = v.p[1].score;
+        int winner = died == 1 ? 1 : died == 2 ? 0 : a == b ? -1 : a > b ? 0 : 1;
+        if (winner < 0) return FramePrintf("Draw - %d : %d", a, b);
+        return FramePrintf("Player %d wins - %d : %d", winner + 1, a, b);
+    }
 
+    // fixed-step simulation like GameScene, both snakes on the one clock
+    void RunTicks(Uint32 now) {
+        Uint64 tickStart = SDL_GetPerformanceCounter();
+        Uint64 nowUs = NowUs();
+        if (nowUs - last > MAX_TICK_BACKLOG_US) last = nowUs - interval;
+        int ticks = 0;
+        while (nowUs - last >= interval) {
+            last += interval;
+            ++ticks;
+            if (gTurbo) for (GameState& s : v.p) s.nextDir = AutopilotDir<B>(s.snake.front());
+            TickResult r[VERSUS_PLAYERS];
+            Rules::template Tick<B>(v, r);
+            for (int i = 0; i < VERSUS_PLAYERS; ++i) {
+                const Point& head = v.p[i].snake.front();
+                if (r[i] == TICK_DIED) {
+                    died |= 1 << i;
+                    VoicePlay(gLoseSound, 1, i == 0 ? -0.5f : 0.5f, 10);
+                    Burst(i, head, 600, 260, 0.9f, SDL_Color{255,80,40,255}, 300);
+                }
+                else if (r[i] == TICK_ATE) {
+                    VoicePlay(gEatSound, 1, i == 0 ? -0.5f : 0.5f);
+                    Burst(i, head, 80, 160, 0.5f, SDL_Color{255,220,60,255});
+                    UpdateScore(i);
+                    if (gTurbo) interval = TurboInterval(SDL_max(v.p[0].score, v.p[1].score));
                 }
-                else { snake.pop_back(); }
             }
-         }
-        SDL_SetRenderDrawColor(ren,0,0,0,255);SDL_RenderClear(ren);
-        SDL_RenderCopy(ren,gBackgroundTexture,nullptr,nullptr);
-        SDL_Rect rf{food.x,food.y,RECT_SIZE,RECT_SIZE}; SDL_RenderCopy(ren,gFoodTexture,nullptr,&rf);
-        if(twoLayer){
-            SDL_Rect rfa{fake.x,fake.y,RECT_SIZE,RECT_SIZE};
-            SDL_RenderCopy(ren,(fakeIsFood ? gFoodTexture : gFakeTexture),nullptr,&rfa);
-        }
-        for(size_t i=0;i<snake.size();++i){ SDL_Rect rs{snake[i].x,snake[i].y,RECT_SIZE,RECT_SIZE}; SDL_RenderCopy(ren,i==0?gHeadTexture:gBodyTexture,nullptr,&rs);}
-        SDL_RenderCopy(ren, scoreTexture, nullptr, &scoreRect);
+            if (died || Rules::template Full<B>(v)) { deathAt = now; break; }
+        }
+        if (ticks == 0) return;
+        PerfTicks(ticks, TelemetryUsSince(tickStart));
+        ScriptSnakeLength((int)SDL_max(v.p[0].snake.size(), v.p[1].snake.size()));
+        redraw = true;
+    }
 
-        SDL_RenderPresent(ren); SDL_Delay(16);
+    SDL_Renderer* ren;
+    TTF_Font* font;
+    VersusGame v;
+    Uint64 last = 0;      // us, time of the last tick
+    unsigned interval;    // us between ticks
+    int died = 0;         // bit i: player i is out
+    Uint32 deathAt = 0;
+    Uint32 lastFrame = 0;
+    SDL_Texture* atlas = nullptr;
+    SDL_Texture* scoreTexture[VERSUS_PLAYERS] = {};
+    SDL_Rect scoreRect[VERSUS_PLAYERS];
+    vector<SDL_Rect> noWalls; // versus has no levels
+    Uint64 renderUs = 0;
+    Uint32 framesDrawn = 0;
+    int peakUs = 0;
+};
+
+Scene* MakeVersusScene(SDL_Renderer* ren, SDL_Window* win, TTF_Font* font) {
+    if (!LoadGameTextures(ren, win, false)) return nullptr;
+    if (gVersusShared) return new VersusScene<VersusShared, SharedBoard>(ren, font);
+    return new VersusScene<VersusSplit, SplitBoard>(ren, font);
+}
+
+// --render-check FILE [--update]: fixed seeded games on the open native
+// board, drawn with SDL's software renderer through each board path (SDL or
+// soft raster, full redraw or incremental). Every frame is read back and
+// hashed. The incremental renderer must match the full redraw frame for
+// frame, and the frames at RENDER_CHECK_TICKS must match the golden file,
+// which only --update writes; a missing file or hash fails. The hashes
+// depend on the SDL build, so keep one golden file per platform, see
+// assets/run_render_check.py.
+const unsigned RENDER_CHECK_SEED = 20240601;
+const int RENDER_CHECK_STEP = 3; // ticks per frame, like a frame that ran late
+const int RENDER_CHECK_TICKS[] = {0, 30, 150, 600, 1200}; // multiples of the step
+
+// One game through one path, the hash of every frame drawn until the last
+// checked tick or the end of the game.
+template<class Mode> vector<Uint64> RenderCheckGame(SDL_Renderer* ren, bool incremental, vector<Uint32>& pixels) {
+    vector<Uint64> frames;
+    srand(RENDER_CHECK_SEED);
+    GameState s;
+    NewGame<Mode>(s);
+    vector<SDL_Rect> walls;
+    DirtyCells d;
+    bool valid = false;
+    gStaticValid = false;
+    const int last = RENDER_CHECK_TICKS[SDL_arraysize(RENDER_CHECK_TICKS) - 1];
+    for (int tick = 0; tick <= last; tick += RENDER_CHECK_STEP) {
+        FrameReset();
+        if (incremental) DrawBoardIncremental<Mode>(ren, s, walls, d, valid);
+        else {
+            DrawBoard<Mode>(ren, s, walls);
+            if (gSoftRaster) SoftRasterFlush(ren);
+        }
+        if (SDL_RenderReadPixels(ren, nullptr, SDL_PIXELFORMAT_ARGB8888, pixels.data(), SCREEN_WIDTH*4) != 0) break;
+        frames.push_back(FrameHash(pixels.data(), SCREEN_WIDTH*4, SCREEN_WIDTH*4, SCREEN_HEIGHT));
+        bool over = false;
+        for (int i = 0; i < RENDER_CHECK_STEP && !over; ++i) {
+            s.nextDir = AutopilotDir(s.snake.front());
+            over = TickMarked<Mode, ScreenBoard>(s, incremental ? &d : nullptr) == TICK_DIED || BoardFull<Mode, ScreenBoard>(s);
+        }
+        if (over) break;
     }
-    if (running == false)
-        savedSnake.clear();
-    SDL_DestroyTexture(scoreTexture);
+    return frames;
+}
 
-    SDL_DestroyTexture(gHeadTexture); SDL_DestroyTexture(gBodyTexture);
-    SDL_DestroyTexture(gFoodTexture);
-    if(twoLayer) SDL_DestroyTexture(gFakeTexture);
+// Both renderers of one mode on one path, returns the failures. With
+// `update` the hashes are only collected, not compared.
+template<class Mode> int RenderCheckMode(SDL_Renderer* ren, const char* path, bool update, const map<string, Uint64>& golden,
+                                         map<string, Uint64>& hashes, vector<Uint32>& pixels) {
+    int bad = 0;
+    vector<Uint64> full = RenderCheckGame<Mode>(ren, false, pixels);
+    vector<Uint64> inc = RenderCheckGame<Mode>(ren, true, pixels);
+    for (size_t f = 0; f < full.size(); ++f) {
+        if (f < inc.size() && inc[f] == full[f]) continue;
+        cout << Mode::Name() << " " << path << ": incremental frame differs from the full redraw at tick " << f * RENDER_CHECK_STEP << endl;
+        ++bad;
+        break;
+    }
+    for (int t : RENDER_CHECK_TICKS) {
+        size_t f = t / RENDER_CHECK_STEP;
+        if (f >= full.size()) break; // the game ended before
+        string name = string(Mode::Name()) + " " + path + " " + to_string(t);
+        hashes[name] = full[f];
+        if (update) continue;
+        auto g = golden.find(name);
+        if (g == golden.end()) {
+            // a partial golden file must not pass
+            cout << name << ": no golden hash" << endl;
+            ++bad;
+        }
+        else if (g->second != full[f]) {
+            cout << name << ": " << hex << full[f] << ", golden " << g->second << dec << endl;
+            ++bad;
+        }
+    }
+    return bad;
+}
+
+int RunRenderCheck(const char* goldenPath, bool update) {
+    // never bless our own output: a missing file (or a typo in the path) fails
+    map<string, Uint64> golden, hashes;
+    if (!update && !GoldenLoad(goldenPath, golden)) {
+        cerr << "No golden file " << goldenPath << ", run with --update on the reference platform" << endl;
+        return 1;
+    }
+    if (SDL_Init(SDL_INIT_VIDEO) != 0 || !(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG)) {
+        cerr << "SDL_Init Error: " << SDL_GetError() << endl;
+        return 1;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* ren = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    gBackgroundTexture = ren ? loadTexture("background.jpg", ren) : nullptr;
+    if (!gBackgroundTexture) {
+        cerr << "Render check setup failed: " << SDL_GetError() << endl;
+        return 1;
+    }
+    vector<Uint32> pixels(SCREEN_WIDTH*SCREEN_HEIGHT);
+    int bad = 0;
+    const char* paths[] = {"sdl", "soft"};
+    for (int p = 0; p < 2; ++p) {
+        gSoftRaster = p == 1;
+        if (gSoftRaster && (!SoftRasterInit(ren, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+                            !SoftRasterAdd(gBackgroundTexture, "background.jpg", SCREEN_WIDTH, SCREEN_HEIGHT))) {
+            cerr << "Soft raster setup failed, path not checked" << endl;
+            ++bad;
+            break;
+        }
+        if (!LoadGameTextures(ren, nullptr, true)) {
+            ++bad;
+            break;
+        }
+        bad += RenderCheckMode<ClassicMode>(ren, paths[p], update, golden, hashes, pixels);
+        bad += RenderCheckMode<TwoLayerMode>(ren, paths[p], update, golden, hashes, pixels);
+        bad += RenderCheckMode<FeastMode>(ren, paths[p], update, golden, hashes, pixels);
+        bad += RenderCheckMode<PowerUpMode>(ren, paths[p], update, golden, hashes, pixels);
+        FreeGameTextures();
+    }
+    if (update) {
+        if (GoldenSave(goldenPath, hashes)) cout << hashes.size() << " golden frames written to " << goldenPath << endl;
+        else {
+            cerr << "Cannot write " << goldenPath << endl;
+            ++bad;
+        }
+    }
+    else cout << hashes.size() << " frames checked, " << bad << " failed" << endl;
+
+    SoftRasterQuit();
+    gSoftRaster = false;
+    SDL_Texture** layers[] = {&gStaticLayer, &gBoardLayer, &gBackgroundTexture};
+    for (SDL_Texture** t : layers) {
+        if (*t) SDL_DestroyTexture(*t);
+        *t = nullptr;
+    }
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    IMG_Quit(); SDL_Quit();
+    return bad ? 1 : 0;
+}
+
+// --alloc-check, frame half: the real scene loop (RunScenes) on SDL's
+// software renderer, played by a built-in script through the menu, every
+// mode and versus with pause and resume, then a game that ends in game
+// over. It runs once per board path. Any allocation in a frame past the
+// warm-up of its scene (Frame_arena.h) fails the check.
+const int ALLOC_CHECK_PLAY_MS = 2000; // per game, most of it steady frames
+
+// Overlays and menus only draw on input, so the script keeps pressing keys
+// to get steady frames out of them; down and up leave the selection as it was.
+string FrameAllocScript(bool gameOver) {
+    const string browse = "repeat 20\nkey Down\nkey Up\nend\n";
+    if (gameOver) {
+        // no autopilot: the snake runs into the wall. Game over ignores the
+        // arrow keys but still draws a frame for each.
+        return "wait_scene menu\nkey Return\nwait_scene game over\nrepeat 40\nkey Left\nend\nkey Return\nwait_scene menu\n";
+    }
+    string s = "wait_scene menu\n" + browse;
+    for (int i = 0; i < 5; ++i) { // the four modes, then versus
+        const string scene = i == 4 ? "versus" : "gameplay";
+        if (i) s += "key Down\n";
+        s += "key Return\nwait_scene " + scene + "\nwait " + to_string(ALLOC_CHECK_PLAY_MS) + "\n";
+        // pause, resume, pause again and quit the game
+        s += "key Escape\nwait_scene pause\n" + browse + "key Escape\nwait_scene " + scene + "\nwait 600\n";
+        s += "key Escape\nwait_scene pause\nkey Down\nkey Return\nwait_scene menu\n";
+    }
+    return s;
+}
+
+int RunFrameAllocCheck() {
+    if (SDL_Init(SDL_INIT_VIDEO) != 0 || !(IMG_Init(IMG_INIT_PNG | IMG_INIT_JPG) & IMG_INIT_PNG) || TTF_Init() != 0) {
+        cerr << "SDL_Init Error: " << SDL_GetError() << endl;
+        return 1;
+    }
+    SDL_Surface* target = SDL_CreateRGBSurfaceWithFormat(0, SCREEN_WIDTH, SCREEN_HEIGHT, 32, SDL_PIXELFORMAT_ARGB8888);
+    SDL_Renderer* ren = target ? SDL_CreateSoftwareRenderer(target) : nullptr;
+    TTF_Font* font = TTF_OpenFont("timesbd.ttf", 24);
+    gBackgroundTexture = ren ? loadTexture("background.jpg", ren) : nullptr;
+    if (!gBackgroundTexture || !font) {
+        cerr << "Frame alloc check setup failed: " << SDL_GetError() << endl;
+        return 1;
+    }
+    struct { const char* name; bool soft, incremental; } paths[] = {{"sdl", false, false}, {"incremental", false, true}, {"soft", true, false}};
+    int bad = 0;
+    for (const auto& p : paths) {
+        gSoftRaster = p.soft;
+        gIncremental = p.incremental;
+        gStaticValid = false;
+        if (gSoftRaster && (!SoftRasterInit(ren, SCREEN_WIDTH, SCREEN_HEIGHT) ||
+                            !SoftRasterAdd(gBackgroundTexture, "background.jpg", SCREEN_WIDTH, SCREEN_HEIGHT))) {
+            cerr << "Soft raster setup failed, path not checked" << endl;
+            ++bad;
+            break;
+        }
+        unsigned long long framesBefore, allocsBefore, frames, allocs;
+        AllocSteadyStats(framesBefore, allocsBefore);
+        // the autopilot keeps the games going, the game over needs it off
+        for (int run = 0; run < 2; ++run) {
+            gTurbo = run == 0;
+            if (!ScriptLoadText(FrameAllocScript(run == 1).c_str(), "frame alloc check")) return 1;
+            ScenePush(MakeMenuScene(ren, nullptr, font));
+            RunScenes(ren, false);
+        }
+        gTurbo = false;
+        AllocSteadyStats(frames, allocs);
+        frames -= framesBefore;
+        allocs -= allocsBefore;
+        cout << "Frames (" << p.name << "): " << allocs << " heap allocations in " << frames << " steady frames" << endl;
+        if (allocs || frames == 0) ++bad;
+    }
+    SoftRasterQuit();
+    gSoftRaster = false;
+    SDL_Texture** layers[] = {&gStaticLayer, &gBoardLayer, &gBackgroundTexture};
+    for (SDL_Texture** t : layers) {
+        if (*t) SDL_DestroyTexture(*t);
+        *t = nullptr;
+    }
+    TTF_CloseFont(font);
+    SDL_DestroyRenderer(ren);
+    SDL_FreeSurface(target);
+    TTF_Quit(); IMG_Quit(); SDL_Quit();
+    return bad ? 1 : 0;
 }
 
 bool LoadMedia() {
     bool success = true;
-    gMusic = loadMusic("assets/RunningAway.mp3");
-    if (gMusic == nullptr) {
-        cerr << "Failed to load music! SDL_mixer Error: " << Mix_GetError() << endl;
+    // one track ships with the game, menu and gameplay share it; the decode
+    // runs in the background, the menu shows before it is done
+    gMenuMusic = gGameMusic = MusicLoad("assets/RunningAway.mp3");
+    if (gMenuMusic < 0) {
+        cerr << "Failed to load music!" << endl;
         success = false;
     }
 
@@ -421,10 +1734,8 @@ bool LoadMedia() {
 }
 
 void FreeMedia() {
-    if (gMusic != nullptr) {
-        Mix_FreeMusic(gMusic);
-        gMusic = nullptr;
-    }
+    VoicesQuit(); // no voice may still read the chunks
+    MusicQuit();
     if (gEatSound != nullptr) {
         Mix_FreeChunk(gEatSound);
         gEatSound = nullptr;